@@ -0,0 +1,250 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L // clock_gettime
+#endif
+
+#include "kernels.h"
+#include "limiter.h"
+#include "synth.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Headless timings for the DSP library. Nothing here touches raylib or an
+// audio device, so it runs anywhere rl_synth_dsp builds.
+
+#define BENCH_BLOCKS 20000
+#define BENCH_STRETCH 0.5f
+#define TAIL_SECONDS 60
+#define TAIL_WINDOWS 6
+
+static const char *shape_names[] = {"sine", "square", "triangle", "sawtooth"};
+
+static double now_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Summed into the report so the compiler can't drop the rendering
+static double checksum(const float *buffer, int frames) {
+  double sum = 0.0;
+  for (int i = 0; i < frames; i++)
+    sum += buffer[i];
+  return sum;
+}
+
+static void bench_voice(FMSynth *fmSynth) {
+  fmSynth->carrierFreq = 220.0f;
+  fmSynth->modulatorFreq = 3.0f;
+  fmSynth->phase = 0.0f;
+  fmSynth->volume = 0.5f;
+  fmSynth->resonance = 2.0f;
+}
+
+// The path the block kernels replaced: shape switch, FM and a freshly
+// computed biquad for every sample
+static void render_per_sample(FMSynth *fmSynth, float *modPhase,
+                              ResonantFilter *filter, const float *env,
+                              float *out, int frames) {
+  for (int i = 0; i < frames; i++) {
+    float mod = sinf(2.0f * PI * *modPhase) * fmSynth->modIndex;
+    float sample = generate_shape(fmSynth->carrierShape, fmSynth->phase);
+    sample *= fmSynth->volume * env[i];
+
+    fmSynth->phase += fmSynth->carrierFreq * (1.0f + mod) / sampleRate;
+    fmSynth->phase -= floorf(fmSynth->phase);
+    *modPhase += fmSynth->modulatorFreq / sampleRate;
+    *modPhase -= floorf(*modPhase);
+
+    BiquadCoeffs coeffs;
+    rope_lowpass_coeffs(&coeffs, BENCH_STRETCH, fmSynth->resonance);
+    biquad_process(filter, &coeffs, &sample, 1);
+    out[i] = sample;
+  }
+}
+
+// Returns nanoseconds per sample
+static double time_per_sample(int shape, bool fm, double *sum) {
+  static float env[AUDIO_BLOCK_SIZE];
+  static float out[AUDIO_BLOCK_SIZE];
+  FMSynth fmSynth = {.carrierShape = shape, .modIndex = fm ? 0.1f : 0.0f};
+  bench_voice(&fmSynth);
+  ResonantFilter filter = {0};
+  float modPhase = 0.0f;
+  for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    env[i] = 1.0f;
+
+  double start = now_seconds();
+  for (int b = 0; b < BENCH_BLOCKS; b++) {
+    render_per_sample(&fmSynth, &modPhase, &filter, env, out,
+                      AUDIO_BLOCK_SIZE);
+    *sum += checksum(out, AUDIO_BLOCK_SIZE);
+  }
+  double elapsed = now_seconds() - start;
+  return elapsed * 1e9 / ((double)BENCH_BLOCKS * AUDIO_BLOCK_SIZE);
+}
+
+static double time_kernel(int shape, bool fm, double *sum) {
+  static float env[AUDIO_BLOCK_SIZE];
+  static float out[AUDIO_BLOCK_SIZE];
+  FMSynth fmSynth = {.carrierShape = shape, .modIndex = fm ? 0.1f : 0.0f};
+  bench_voice(&fmSynth);
+  ResonantFilter filter = {0};
+  float modPhase = 0.0f;
+  for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    env[i] = 1.0f;
+  RenderKernel kernel = select_render_kernel(shape, fm, FILTER_BIQUAD, true);
+
+  double start = now_seconds();
+  for (int b = 0; b < BENCH_BLOCKS; b++) {
+    // Coefficients once per block, as the instrument callbacks do
+    BiquadCoeffs coeffs;
+    rope_lowpass_coeffs(&coeffs, BENCH_STRETCH, fmSynth.resonance);
+    kernel(&fmSynth, &modPhase, &filter, &coeffs, env, out, AUDIO_BLOCK_SIZE);
+    *sum += checksum(out, AUDIO_BLOCK_SIZE);
+  }
+  double elapsed = now_seconds() - start;
+  return elapsed * 1e9 / ((double)BENCH_BLOCKS * AUDIO_BLOCK_SIZE);
+}
+
+static void bench_kernels(double *sum) {
+  printf("Voice render, biquad and envelope, ns/sample\n");
+  printf("%-10s %-4s %12s %12s %8s\n", "shape", "fm", "per-sample", "kernel",
+         "speedup");
+  for (int shape = SINE; shape <= SAWTOOTH; shape++) {
+    for (int fm = 0; fm < 2; fm++) {
+      double reference = time_per_sample(shape, fm, sum);
+      double kernel = time_kernel(shape, fm, sum);
+      printf("%-10s %-4s %12.2f %12.2f %7.1fx\n", shape_names[shape],
+             fm ? "on" : "off", reference, kernel, reference / kernel);
+    }
+  }
+}
+
+// One note, then a minute of nothing through the whole engine. This runs
+// with FTZ/DAZ on and lets voices go dormant, so it shows the tail stays
+// cheap in practice; bench_ringing_without_ftz isolates the guards.
+static void bench_silent_tail(double *sum) {
+  static float out[AUDIO_BLOCK_SIZE * CHANNELS];
+  SynthControls controls = {.leadFreq = 220.0f,
+                            .stretch = BENCH_STRETCH,
+                            .direction = 0.25f,
+                            .arpMode = UP};
+  synth_set_controls(&controls);
+  for (int j = 0; j < MAX_INSTRUMENTS; j++)
+    Instruments[j].volume = 0.0f;
+  Instruments[1].volume = 0.8f;
+  Instruments[2].volume = 0.8f;
+  synth_trigger_beat();
+  synth_trigger_sub_beat();
+
+  int blocks = (int)(TAIL_SECONDS * sampleRate / AUDIO_BLOCK_SIZE);
+  int window = blocks / TAIL_WINDOWS;
+  printf("\nSilent tail after one note, ns/block per %d s window\n",
+         TAIL_SECONDS / TAIL_WINDOWS);
+  for (int w = 0; w < TAIL_WINDOWS; w++) {
+    double start = now_seconds();
+    for (int b = 0; b < window; b++) {
+      synth_render(out, NULL, AUDIO_BLOCK_SIZE);
+      *sum += checksum(out, AUDIO_BLOCK_SIZE * CHANNELS);
+    }
+    double elapsed = now_seconds() - start;
+    printf("%3d s %10.0f\n", w * TAIL_SECONDS / TAIL_WINDOWS,
+           elapsed * 1e9 / window);
+  }
+}
+
+// FTZ/DAZ off, so only the explicit flush_denormal guards stand between
+// the filters and subnormals. Only x86 is switched back here.
+static bool set_flush_to_zero(bool on) {
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86_FP)
+  unsigned int csr = _mm_getcsr();
+  _mm_setcsr(on ? csr | 0x8040 : csr & ~0x8040u);
+  return true;
+#else
+  (void)on;
+  return false;
+#endif
+}
+
+// biquad_process without the flushes, to show what they prevent
+static void biquad_unguarded(ResonantFilter *filter, const BiquadCoeffs *c,
+                             float *buffer, int frames) {
+  float x1 = filter->prev_x, x2 = filter->prev_x2;
+  float y1 = filter->prev_y1, y2 = filter->prev_y2;
+  for (int i = 0; i < frames; i++) {
+    float x = buffer[i];
+    float y = c->b0 * x + c->b1 * x1 + c->b2 * x2 - c->a1 * y1 - c->a2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    buffer[i] = y;
+  }
+  filter->prev_x = x1;
+  filter->prev_x2 = x2;
+  filter->prev_y1 = y1;
+  filter->prev_y2 = y2;
+}
+
+// A muted voice whose resonant filter and the limiter ring down on silent
+// input, with no dormancy to stop them, timed per window
+static void time_ringing_voice(bool guarded, double *ns_per_block,
+                               double *sum) {
+  static float left[AUDIO_BLOCK_SIZE];
+  static float right[AUDIO_BLOCK_SIZE];
+  ResonantFilter filter = {0};
+  Limiter limiter = {0};
+  BiquadCoeffs coeffs;
+  rope_lowpass_coeffs(&coeffs, BENCH_STRETCH, 8.0f);
+
+  // One loud block to set it ringing, then the voice is muted
+  for (int i = 0; i < AUDIO_BLOCK_SIZE; i++)
+    left[i] = i & 32 ? 0.8f : -0.8f;
+  int blocks = (int)(TAIL_SECONDS * sampleRate / AUDIO_BLOCK_SIZE);
+  int window = blocks / TAIL_WINDOWS;
+  for (int w = 0; w < TAIL_WINDOWS; w++) {
+    double start = now_seconds();
+    for (int b = 0; b < window; b++) {
+      if (guarded)
+        biquad_process(&filter, &coeffs, left, AUDIO_BLOCK_SIZE);
+      else
+        biquad_unguarded(&filter, &coeffs, left, AUDIO_BLOCK_SIZE);
+      memcpy(right, left, sizeof(right));
+      limiter_process(&limiter, left, right, AUDIO_BLOCK_SIZE);
+      *sum += checksum(right, AUDIO_BLOCK_SIZE);
+      memset(left, 0, sizeof(left));
+    }
+    ns_per_block[w] = (now_seconds() - start) * 1e9 / window;
+  }
+}
+
+static void bench_ringing_without_ftz(double *sum) {
+  printf("\nMuted voice ringing down without FTZ/DAZ, ns/block per %d s "
+         "window\n",
+         TAIL_SECONDS / TAIL_WINDOWS);
+  if (!set_flush_to_zero(false)) {
+    printf("skipped: FTZ/DAZ can't be switched off on this target\n");
+    return;
+  }
+  double guarded[TAIL_WINDOWS], unguarded[TAIL_WINDOWS];
+  time_ringing_voice(true, guarded, sum);
+  time_ringing_voice(false, unguarded, sum);
+  set_flush_to_zero(true);
+
+  printf("%5s %10s %10s\n", "", "guarded", "unguarded");
+  for (int w = 0; w < TAIL_WINDOWS; w++) {
+    printf("%3d s %10.0f %10.0f\n", w * TAIL_SECONDS / TAIL_WINDOWS,
+           guarded[w], unguarded[w]);
+  }
+}
+
+int main() {
+  denormals_disable();
+  double sum = 0.0;
+  bench_kernels(&sum);
+  bench_silent_tail(&sum);
+  bench_ringing_without_ftz(&sum);
+  printf("(checksum %g)\n", sum);
+  return 0;
+}
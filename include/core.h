@@ -2,6 +2,18 @@
 
 #include "utils.h"
 
+enum FramePacingModes { PACING_VSYNC = 0, PACING_TARGET_FPS = 1 };
+
+typedef struct {
+  int mode;
+  int target_fps;   // Redraw rate for PACING_TARGET_FPS
+  int idle_fps;     // Redraw rate while the rope rests and nothing plays
+  double spin_tail; // Seconds to busy-wait before each frame deadline
+} FramePacing;
+
+// Applies at once; before core_init_window it also sets the vsync hint
+void core_set_frame_pacing(FramePacing pacing);
+
 bool core_init_window(const char *title);
 
 bool core_window_should_close();
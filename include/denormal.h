@@ -0,0 +1,33 @@
+#pragma once
+
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86_FP)
+#include <xmmintrin.h>
+#endif
+
+// Values this small are inaudible; snapping filter state to zero below it
+// keeps recursive paths from decaying into subnormals on hardware or
+// targets where flush-to-zero isn't available
+#define DENORMAL_THRESHOLD 1e-15f
+
+static inline float flush_denormal(float x) {
+  return fabsf(x) < DENORMAL_THRESHOLD ? 0.0f : x;
+}
+
+// Flush subnormal results and inputs to zero on the calling thread. The
+// mode is per thread, so the audio callback and each worker call this.
+// WebAssembly has no such mode; the explicit guards cover it there.
+static inline void denormals_disable() {
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86_FP)
+  _mm_setcsr(_mm_getcsr() | 0x8040); // FTZ | DAZ
+#elif defined(__aarch64__)
+  unsigned long fpcr;
+  __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+  __asm__ volatile("msr fpcr, %0" : : "r"(fpcr | (1UL << 24))); // FZ
+#elif defined(__arm__) && defined(__ARM_FP)
+  unsigned int fpscr;
+  __asm__ volatile("vmrs %0, fpscr" : "=r"(fpscr));
+  __asm__ volatile("vmsr fpscr, %0" : : "r"(fpscr | (1U << 24))); // FZ
+#endif
+}
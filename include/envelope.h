@@ -0,0 +1,39 @@
+#pragma once
+
+#include "dsp_config.h"
+
+typedef struct {
+  float attack;  // Seconds
+  float decay;   // Seconds
+  float sustain; // Level held while the gate is open
+  float release; // Seconds
+  float gate;    // Seconds until the note is released, 0 holds it
+} EnvControls;
+
+enum EnvStages {
+  ENV_IDLE = 0,
+  ENV_ATTACK = 1,
+  ENV_DECAY = 2,
+  ENV_SUSTAIN = 3,
+  ENV_RELEASE = 4
+};
+
+// Per-voice ADSR state. Each segment is an exponential approach towards an
+// overshoot target, so a sample costs one multiply-add: level = base + level *
+// coef. Coefficients are computed at gate events, never per sample.
+typedef struct {
+  int stage;
+  float level;
+  float coef;   // Current segment multiplier
+  float base;   // Current segment offset
+  float target; // Level at which the current segment ends
+  float decay_coef;
+  float decay_base;
+  float sustain;
+} Envelope;
+
+void envelope_gate_on(Envelope *env, const EnvControls *envControls);
+
+void envelope_gate_off(Envelope *env, const EnvControls *envControls);
+
+void envelope_render(Envelope *env, float *out, int frames);
@@ -0,0 +1,29 @@
+#pragma once
+
+// Kept free of raylib includes: governor.c needs the platform clock headers
+#include <stdbool.h>
+#include <stdint.h>
+
+enum QualityTiers {
+  QUALITY_FULL = 0,           // Everything on
+  QUALITY_CHEAP_FILTER = 1,   // One-pole lowpass instead of the resonant biquad
+  QUALITY_FEWER_VOICES = 2,   // Capped polyphony
+  QUALITY_BYPASS = 3,         // Filters and analysis tap bypassed
+  QUALITY_TIER_COUNT = 4
+};
+
+#define GOVERNOR_HIGH_LOAD 0.7f  // Fraction of the period budget
+#define GOVERNOR_LOW_LOAD 0.35f
+#define GOVERNOR_DOWN_PERIODS 4  // Overloaded periods before stepping down
+#define GOVERNOR_UP_PERIODS 400  // Relaxed periods before stepping back up
+#define GOVERNOR_SMOOTHING 0.2f  // Weight of the newest load measurement
+
+double governor_now();
+
+void governor_update(double start_time, uint32_t frames, float sample_rate);
+
+int governor_tier();
+
+float governor_load();
+
+const char *governor_tier_name(int tier);
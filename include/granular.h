@@ -0,0 +1,62 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define GRANULAR_MAX_GRAINS 256
+#define GRANULAR_REDUCED_GRAINS 64 // Grains under the reduced quality tiers
+#define GRANULAR_HISTORY_SIZE (1 << 18) // Output history, power of two
+#define GRANULAR_WINDOW_SIZE 1024       // Hann table entries
+#define GRANULAR_PAN_STEPS 64           // Equal-power pan table entries
+#define GRANULAR_MIN_SIZE 0.01f         // Grain length range in seconds
+#define GRANULAR_MAX_SIZE 0.2f
+#define GRANULAR_MIN_DENSITY 5.0f // Grains per second
+#define GRANULAR_MAX_DENSITY 400.0f
+#define GRANULAR_MAX_PITCH 2.0f
+#define GRANULAR_SOURCE_PATH "samples/grains.wav"
+
+enum GranularSources {
+  GRANULAR_SOURCE_HISTORY = 0,
+  GRANULAR_SOURCE_SAMPLE = 1
+};
+
+// Set once per block from the rope
+typedef struct {
+  float density;  // Grains per second
+  float size;     // Grain length in seconds
+  float position; // 0 .. 1, how far back in the history or into the sample
+  float pitch;    // Playback rate, 1 is the original pitch
+} GranularControls;
+
+// Grains link through `next` into either the free list or the active list
+typedef struct Grain {
+  struct Grain *next;
+  uint32_t index;      // Integer read position in source frames
+  float frac;          // Fractional read position
+  float rate;          // Source frames advanced per output sample
+  float window;        // Position in the window table
+  float window_step;   // Table entries advanced per output sample
+  float gain_left;
+  float gain_right;
+  int offset; // Frame in the current block where the grain starts
+} Grain;
+
+bool granular_open_source(const char *path);
+
+void granular_init();
+
+void granular_set_enabled(bool enabled);
+
+bool granular_enabled();
+
+const char *granular_source_name();
+
+void granular_set_grain_limit(int limit);
+
+int granular_active_grains();
+
+void granular_capture(const float *in, int frames);
+
+void granular_render(const GranularControls *controls, float *out_left,
+                     float *out_right, int frames);
+
+void granular_shutdown();
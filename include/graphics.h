@@ -4,4 +4,8 @@
 
 void draw_horizontal_waveforms();
 void draw_circular_waveforms();
-void draw_note_grid(vec2 rope_start, vec2 rope_end);
+void draw_note_grid();
+void draw_static_layers();
+void invalidate_static_layers();
+void unload_static_layers();
+void draw_spectrum();
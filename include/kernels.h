@@ -0,0 +1,56 @@
+#pragma once
+
+#include "denormal.h"
+#include "synth.h"
+
+// Block renderer for one (waveform, FM, filter mode, envelope) combination
+typedef void (*RenderKernel)(FMSynth *fmSynth, float *modPhase,
+                             ResonantFilter *filter,
+                             const BiquadCoeffs *coeffs, const float *env,
+                             float *out, int frames);
+
+RenderKernel select_render_kernel(int shape, bool fm, int filterMode,
+                                  bool env);
+
+static inline void biquad_process(ResonantFilter *filter,
+                                  const BiquadCoeffs *c, float *buffer,
+                                  int frames) {
+  float x1 = filter->prev_x, x2 = filter->prev_x2;
+  float y1 = filter->prev_y1, y2 = filter->prev_y2;
+  for (int i = 0; i < frames; i++) {
+    float x = buffer[i];
+    float y = c->b0 * x + c->b1 * x1 + c->b2 * x2 - c->a1 * y1 - c->a2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    buffer[i] = y;
+  }
+  // A muted voice rings down towards subnormals without this
+  filter->prev_x = flush_denormal(x1);
+  filter->prev_x2 = flush_denormal(x2);
+  filter->prev_y1 = flush_denormal(y1);
+  filter->prev_y2 = flush_denormal(y2);
+}
+
+// Cheap fallback for the biquad; coeffs->b0 holds the smoothing factor
+static inline void one_pole_process(ResonantFilter *filter,
+                                    const BiquadCoeffs *c, float *buffer,
+                                    int frames) {
+  float alpha = c->b0;
+  float y = filter->prev_y1;
+  for (int i = 0; i < frames; i++) {
+    y += alpha * (buffer[i] - y);
+    buffer[i] = y;
+  }
+  filter->prev_y1 = flush_denormal(y);
+}
+
+static inline void filter_process(ResonantFilter *filter, int filterMode,
+                                  const BiquadCoeffs *c, float *buffer,
+                                  int frames) {
+  if (filterMode == FILTER_BIQUAD)
+    biquad_process(filter, c, buffer, frames);
+  else if (filterMode == FILTER_ONE_POLE)
+    one_pole_process(filter, c, buffer, frames);
+}
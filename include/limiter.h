@@ -0,0 +1,16 @@
+#pragma once
+
+#define LIMITER_THRESHOLD 0.9f // Peak level the gain stage holds to
+#define LIMITER_RELEASE 0.1f   // Seconds for the gain to recover
+#define LIMITER_KNEE 0.95f     // Soft clip is linear below this level
+
+// Peak limiter with instant attack, followed by a soft clipper that
+// catches whatever the release lets through
+typedef struct {
+  float envelope;
+  float release_coef;
+  float coef_rate; // Sample rate release_coef was computed for
+} Limiter;
+
+void limiter_process(Limiter *limiter, float *left, float *right,
+                     int frames);
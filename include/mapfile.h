@@ -0,0 +1,19 @@
+#pragma once
+
+// Kept free of raylib includes: mapfile.c pulls in platform headers that
+// clash with raylib's names on Windows.
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+  const void *data;
+  size_t size;
+  void *handle;  // Windows file handle, unused elsewhere
+  void *mapping; // Windows mapping handle, unused elsewhere
+} MappedFile;
+
+bool map_file(const char *path, MappedFile *file);
+void unmap_file(MappedFile *file);
+
+void prefault_mapped_file(const MappedFile *file, size_t offset,
+                          size_t length);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "dsp_config.h"
+#include "envelope.h"
+
+#define PRESET_MAGIC 0x50534c52u // "RLSP" read as a little-endian uint32
+#define PRESET_VERSION 4
+#define PRESET_PATH "preset.rlsp"
+#define PRESET_MAX_RETIRED 8
+
+// On-disk layout is the in-memory layout: only fixed-width fields, no
+// pointers, so a mapped file can be validated and used without parsing.
+typedef struct {
+  float carrierFreq;
+  int32_t carrierShape;
+  float modulatorFreq;
+  float modIndex;
+  float resonance;
+  float volume;
+  EnvControls envControls;
+  int32_t unison;
+  float detune;
+  float stereoSpread;
+  int32_t sequence[SEQ_SIZE];
+} InstrumentPreset;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;     // sizeof(SynthPreset) when written
+  uint32_t checksum; // FNV-1a over everything after the header
+  InstrumentPreset instruments[MAX_INSTRUMENTS];
+  float min_bpm;
+  float max_bpm;
+  int32_t arp_mode;
+  float rope_damping;
+  float rope_compliance;
+} SynthPreset;
+
+void preset_capture(SynthPreset *preset);
+
+const SynthPreset *preset_validate(const void *data, size_t size);
+
+bool preset_save(const char *path);
+
+bool preset_load(const char *path);
+
+void preset_collect();
+
+void preset_shutdown();
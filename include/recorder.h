@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define RECORDER_RING_FRAMES (1 << 20) // ~20 s of slack at 48 kHz
+#define RECORDER_CHUNK_FRAMES (1 << 15) // Frames per disk write
+#define RECORDER_PATH_FORMAT "recording_%03d.wav"
+#define RECORDER_FORMAT RECORD_F32
+
+enum RecordFormats { RECORD_F32 = 0, RECORD_S16 = 1 };
+
+bool recorder_start(const char *path, int format);
+
+void recorder_stop();
+
+bool recorder_is_recording();
+
+void recorder_write(const float *frames, uint32_t frameCount);
+
+void recorder_update();
+
+uint64_t recorder_frames_written();
+
+uint64_t recorder_dropped_frames();
@@ -8,15 +8,19 @@ typedef struct {
   vec2 end_prev;
   vec2 points[ROPE_POINTS];
   vec2 velocities[ROPE_POINTS]; // Added to store point velocities
-  float damping;                // Added for energy loss
-  float stiffness;              // Added for spring stiffness
+  float lambdas[ROPE_POINTS - 1]; // Accumulated XPBD constraint multipliers
+  float damping;                  // Added for energy loss
+  float compliance;               // Inverse stiffness, independent of dt
+  int iterations;                 // Solver passes used by the last step
+  int still_steps;                // Consecutive steps without visible motion
   Color color;
 } Rope;
 
 void init_rope(Rope *rope, vec2 start, vec2 end, Color color);
-void solve_rope_constraints(Rope *rope);
-void update_rope(Rope *rope);
+float solve_rope_constraints(Rope *rope, float alpha_tilde);
+void update_rope(Rope *rope, vec2 pointer, bool pointer_down);
 void draw_rope(Rope *rope);
+bool rope_is_at_rest(Rope *rope);
 
 float freq_from_rope_dir(Rope *rope);
 void rope_bpm_controller(Rope *rope, GlobalControls *globalControls);
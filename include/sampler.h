@@ -0,0 +1,74 @@
+#pragma once
+
+#include "dsp_config.h"
+#include "mapfile.h"
+#include <string.h>
+
+#define SAMPLER_MAX_SLOTS 8
+#define SAMPLER_MAX_VOICES 32
+#define SAMPLER_REDUCED_VOICES 8 // Polyphony under the reduced quality tiers
+#define SAMPLER_KIT_PATH "samples/kit_%d.wav"
+#define SAMPLER_ROOT_NOTE C2 // Note that plays a sample at its recorded pitch
+#define SAMPLER_PREFAULT_BYTES (256 * 1024) // Resident head of each sample
+
+enum SampleFormats { SAMPLE_S16 = 0, SAMPLE_F32 = 1 };
+
+// PCM data points straight into the mapped WAV file, nothing is copied
+typedef struct {
+  MappedFile file;
+  const unsigned char *data;
+  int format;
+  int channels;
+  uint32_t frame_count;
+  float sample_rate;
+  bool looped;
+  uint32_t loop_start;
+  uint32_t loop_end;
+} Sample;
+
+typedef struct {
+  const Sample *sample;
+  int slot;
+  uint32_t index; // Integer read position in frames
+  float frac;     // Fractional read position
+  float rate;     // Frames advanced per output sample
+  float gain;
+  uint32_t age;
+  bool active;
+} SamplerVoice;
+
+bool sample_open(Sample *sample, const char *path);
+
+void sample_close(Sample *sample);
+
+// Mono frame at index, mixing stereo files down
+static inline float sample_read_frame(const Sample *sample, uint32_t index) {
+  if (sample->format == SAMPLE_S16) {
+    int16_t pcm[2];
+    memcpy(pcm, sample->data + index * sample->channels * 2,
+           sample->channels * 2);
+    float value = pcm[0];
+    if (sample->channels == 2)
+      value = 0.5f * (value + pcm[1]);
+    return value * (1.0f / 32768.0f);
+  }
+
+  float pcm[2];
+  memcpy(pcm, sample->data + index * sample->channels * 4,
+         sample->channels * 4);
+  return sample->channels == 2 ? 0.5f * (pcm[0] + pcm[1]) : pcm[0];
+}
+
+bool sampler_load(int slot, const char *path);
+
+int sampler_load_kit(const char *pattern);
+
+int sampler_slot_count();
+
+void sampler_set_voice_limit(int limit);
+
+void sampler_trigger(int slot, float pitch, float gain);
+
+void sampler_render(float *out, int frames);
+
+void sampler_shutdown();
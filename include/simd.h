@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Four-wide float vectors from GCC/Clang vector extensions; these lower to
+// SSE, NEON or wasm SIMD. Code using them keeps a scalar path for compilers
+// without SIMD_VECTORS.
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_VECTORS 1
+
+typedef float v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+
+// Masks from comparisons are all-ones, so and-ing them with the bits of
+// 1.0f gives 1.0f or 0.0f
+#define V_ONE ((v4f){1.0f, 1.0f, 1.0f, 1.0f})
+#define V_HALF ((v4f){0.5f, 0.5f, 0.5f, 0.5f})
+#define V_STEP(mask) ((v4f)((mask) & (v4i)V_ONE))
+#define V_ABS(x)                                                               \
+  ((v4f)((v4i)(x) & (v4i){0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff}))
+
+static inline v4f v4f_load(const float *p) {
+  v4f v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void v4f_store(float *p, v4f v) { memcpy(p, &v, sizeof(v)); }
+
+static inline float v4f_sum(v4f v) { return (v[0] + v[1]) + (v[2] + v[3]); }
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define SPECTRUM_FFT_SIZE 2048
+#define SPECTRUM_TAP_SIZE 8192 // Power of two, several FFT frames deep
+#define SPECTRUM_BINS 64
+#define SPECTRUM_MIN_FREQ 30.0f
+#define SPECTRUM_MAX_FREQ 16000.0f
+#define SPECTRUM_FLOOR_DB -90.0f
+#define SPECTRUM_RATE 60         // Analyses per second
+#define SPECTRUM_RELEASE 0.85f   // Per-analysis fall of the bar levels
+#define SPECTRUM_PEAK_FALL 0.4f  // Peak marker fall per second
+#define SPECTRUM_HEIGHT 120
+
+// Levels are normalised to 0..1 over SPECTRUM_FLOOR_DB..0 dBFS
+typedef struct {
+  float levels[SPECTRUM_BINS];
+  float peaks[SPECTRUM_BINS];
+} SpectrumFrame;
+
+void spectrum_init();
+
+void spectrum_shutdown();
+
+void spectrum_tap(const float *samples, int frames);
+
+void spectrum_update(float dt);
+
+const SpectrumFrame *spectrum_latest();
@@ -1,7 +1,8 @@
 #pragma once
 
-#include "miniaudio.h"
-#include "utils.h"
+#include "dsp_config.h"
+#include "envelope.h"
+#include "preset.h"
 
 typedef struct {
   float frequency;
@@ -11,6 +12,8 @@ typedef struct {
   float buffer[BUFFER_SIZE];
 } Synthesizer;
 
+enum VoiceTypes { VOICE_FM = 0, VOICE_SAMPLER = 1 };
+
 typedef struct {
   float carrierFreq;
   int carrierShape;
@@ -22,21 +25,48 @@ typedef struct {
   int currentNote;
   float resonance;
   float volume;
+  EnvControls envControls; // Gated per note by the sequencer
+  int voiceType;           // VOICE_SAMPLER plays the loaded kit instead
+  int unison;              // Detuned sub-oscillators, 1 disables unison
+  float detune;            // Spread between outermost sub-oscillators (cents)
+  float stereoSpread;      // 0 keeps the stack centred, 1 pans it hard
 } FMSynth;
 
 typedef struct {
   float prev_x;  // Previous input
+  float prev_x2; // Input before that
   float prev_y1; // Previous output 1
   float prev_y2; // Previous output 2
 } ResonantFilter;
 
 typedef struct {
-  float attack;
-  float decay;
-  float sustain;
-  float release;
-  float phase;
-} EnvControls;
+  float b0, b1, b2;
+  float a1, a2;
+} BiquadCoeffs;
+
+enum FilterModes {
+  FILTER_NONE = 0,
+  FILTER_BIQUAD = 1,
+  FILTER_ONE_POLE = 2,
+  FILTER_MODE_COUNT = 3
+};
+
+// Render setup an instrument callback picks for the coming block
+typedef struct {
+  int filterMode;
+  bool useEnvelope;
+  BiquadCoeffs filter;
+} VoiceBlock;
+
+// Control inputs the app derives from the rope, in normalised units so the
+// engine needs no knowledge of the scene
+typedef struct {
+  float leadFreq;  // Lead carrier frequency in Hz
+  float stretch;   // Rope length over its maximum, drives the filters
+  float direction; // 0 .. 1 around the rope's anchor
+  float motion;    // 0 .. 1, speed of the rope's free end
+  int arpMode;
+} SynthControls;
 
 typedef struct {
   float delayTime;
@@ -52,22 +82,33 @@ float calculate_alpha_cutoff(float cut_off);
 
 void lowpass_callback(float *sample, float *prev_y, float alpha);
 
-void rope_lowpass_callback(float *sample, ResonantFilter *filter,
-                           float rope_length, float resonance);
+void resonant_lowpass_coeffs(BiquadCoeffs *coeffs, float cutoff,
+                             float resonance);
 
-void envelope_callback(float *sample, EnvControls *envControls);
+void rope_lowpass_coeffs(BiquadCoeffs *coeffs, float stretch,
+                         float resonance);
 
 void delay_callback(float *sample, float *buffer, float *delay_time,
                     float *feedback, float *wet);
 
-void lead_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                         float *modPhase);
+void lead_synth_callback(FMSynth *fmSynth, VoiceBlock *block);
+
+void rhythm_synth_callback(FMSynth *fmSynth, VoiceBlock *block);
+
+void arpeggio_synth_callback(FMSynth *fmSynth, VoiceBlock *block);
+
+void const_synth_callback(FMSynth *fmSynth, VoiceBlock *block);
+
+bool synth_is_silent();
+
+void synth_queue_preset(const SynthPreset *preset);
+
+uint32_t synth_audio_epoch();
+
+void synth_set_controls(const SynthControls *controls);
 
-void rhythm_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                           float *modPhase);
+void synth_trigger_beat();
 
-void arpeggio_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                             float *modPhase);
+void synth_trigger_sub_beat();
 
-void audio_callback(ma_device *device, void *output, const void *input,
-                    ma_uint32 frameCount);
+void synth_render(float *out, const float *input, uint32_t frames);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define UNISON_MAX_VOICES 16
+#define UNISON_REDUCED_VOICES 4 // Cap under the reduced quality tiers
+#define UNISON_LANES 4          // Sub-oscillators advanced per vector op
+
+// Sub-oscillators are stored in lane order so one vector op advances
+// UNISON_LANES of them at once
+typedef struct {
+  float phases[UNISON_MAX_VOICES];
+  float increments[UNISON_MAX_VOICES];
+  float gains_left[UNISON_MAX_VOICES];
+  float gains_right[UNISON_MAX_VOICES];
+  bool seeded;
+} UnisonState;
+
+void unison_render(UnisonState *state, int shape, int voices, float frequency,
+                   float detune, float spread, float volume, const float *env,
+                   float *out_left, float *out_right, int frames);
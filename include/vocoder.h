@@ -0,0 +1,34 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define VOCODER_BANDS 24 // Multiple of 4, one SIMD lane per band
+#define VOCODER_MIN_FREQ 100.0f
+#define VOCODER_MAX_FREQ 8000.0f
+#define VOCODER_ATTACK 0.005f // Envelope follower times in seconds
+#define VOCODER_RELEASE 0.03f
+#define VOCODER_GAIN 4.0f // Make-up for the narrow carrier bands
+#define VOCODER_INPUT_PATH "samples/voice.wav"
+
+enum VocoderSources {
+  VOCODER_SOURCE_NONE = 0,
+  VOCODER_SOURCE_DEVICE = 1,
+  VOCODER_SOURCE_FILE = 2
+};
+
+bool vocoder_open_input(const char *path);
+
+void vocoder_init(bool capture);
+
+void vocoder_set_enabled(bool enabled);
+
+bool vocoder_enabled();
+
+int vocoder_source();
+
+const char *vocoder_source_name();
+
+void vocoder_process(const float *input, const float *carrier, float *out,
+                     int frames);
+
+void vocoder_shutdown();
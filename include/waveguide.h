@@ -0,0 +1,41 @@
+#pragma once
+
+#include "dsp_config.h"
+
+#define WAVEGUIDE_MAX_STRINGS 32
+#define WAVEGUIDE_REDUCED_STRINGS 8 // Strings under the reduced quality tiers
+#define WAVEGUIDE_RING_SIZE 4096    // Power of two so wrapping is a mask
+#define WAVEGUIDE_MIN_FREQ 30.0f    // Lowest pitch that fits the ring
+#define WAVEGUIDE_EVENTS 64         // Pending plucks, power of two
+#define WAVEGUIDE_DECAY 4.0f        // Seconds to fall 60 dB
+#define WAVEGUIDE_MAX_SPEED 3000.0f // Release speed (px/s) for a full pluck
+#define WAVEGUIDE_GAIN 0.5f
+
+typedef struct {
+  float frequency;
+  float velocity; // 0 .. 1, sets the pluck amplitude
+  float tension;  // 0 .. 1, sets the brightness
+} PluckEvent;
+
+// Karplus-Strong loop: delay ring -> one-pole damping -> tuning allpass
+typedef struct {
+  float ring[WAVEGUIDE_RING_SIZE];
+  uint32_t write;
+  uint32_t delay;     // Integer part of the loop length
+  float allpass_coef; // Fractional part of the loop length
+  float allpass_x1;
+  float allpass_y1;
+  float damping; // One-pole coefficient, higher is duller
+  float damping_state;
+  float loss; // Gain per trip round the loop
+  uint32_t age;
+  bool active;
+} WaveguideString;
+
+void waveguide_pluck(float frequency, float velocity, float tension);
+
+void waveguide_set_string_limit(int limit);
+
+void waveguide_render(float *out, int frames);
+
+int waveguide_active_strings();
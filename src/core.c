@@ -1,49 +1,207 @@
 #include "core.h"
+#include "governor.h"
+#include "granular.h"
 #include "graphics.h"
+#include "preset.h"
+#include "recorder.h"
 #include "rope.h"
+#include "sampler.h"
+#include "spectrum.h"
 #include "synth.h"
+#include "unison.h"
 #include "utils.h"
+#include "vocoder.h"
+#include "waveguide.h"
 #include <raylib.h>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio.h"
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
 static ma_device device; // Global audio device
 Rope rope;
 GlobalControls globalControls;
 
-bool core_init_window(const char *title) {
-  // Initialize audio device
-  ma_device_config deviceConfig =
-      ma_device_config_init(ma_device_type_playback);
+static FramePacing pacing = {.mode = PACING_TARGET_FPS,
+                             .target_fps = TARGET_FPS,
+                             .idle_fps = IDLE_FPS,
+                             .spin_tail = FRAME_SPIN_TAIL};
+static double next_frame_time = 0.0;
+static bool idle = false;
+
+void core_set_frame_pacing(FramePacing newPacing) {
+  pacing = newPacing;
+  if (!IsWindowReady())
+    return; // core_init_window picks it up
+  if (pacing.mode == PACING_VSYNC)
+    SetWindowState(FLAG_VSYNC_HINT);
+  else
+    ClearWindowState(FLAG_VSYNC_HINT);
+  next_frame_time = GetTime();
+}
+
+static void audio_callback(ma_device *device, void *output, const void *input,
+                           ma_uint32 frameCount) {
+  if (!device || !output)
+    return;
+  synth_render((float *)output, (const float *)input, frameCount);
+}
+
+// Hand the rope's state to the engine as normalised control inputs
+static void update_synth_controls() {
+  vec2 direction = Vector2Subtract(rope.end, rope.start);
+  float speed = Vector2Length(rope.velocities[ROPE_POINTS - 1]);
+  SynthControls controls = {
+      .leadFreq = freq_from_rope_dir(&rope),
+      .stretch = Vector2Length(direction) / MAX_ROPE_LENGTH,
+      .direction = (atan2f(direction.y, direction.x) + PI) / (2.0f * PI),
+      .motion = fminf(speed / MAX_ROPE_SPEED, 1.0f),
+      .arpMode = globalControls.arp_mode};
+  synth_set_controls(&controls);
+}
+
+// Anything that can still change the picture or the sound keeps the full
+// frame rate: ringing strings, live grains, live input and the REC readout
+static bool core_is_idle() {
+  return rope_is_at_rest(&rope) && synth_is_silent() &&
+         waveguide_active_strings() == 0 && granular_active_grains() == 0 &&
+         !vocoder_enabled() && !recorder_is_recording() &&
+         !IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+}
+
+static void update_idle_state() {
+  bool now_idle = core_is_idle();
+  if (now_idle == idle)
+    return;
+  idle = now_idle;
+#ifdef __EMSCRIPTEN__
+  // The browser drives frames, so skip animation frames instead of sleeping
+  int swap_interval = 1;
+  if (idle && pacing.idle_fps > 0 && pacing.idle_fps < TARGET_FPS)
+    swap_interval = TARGET_FPS / pacing.idle_fps;
+  emscripten_set_main_loop_timing(EM_TIMING_RAF, swap_interval);
+#endif
+}
+
+// Sleep until the next frame deadline, then spin through the last stretch
+// since OS sleeps routinely overshoot by a millisecond or more.
+static void wait_for_next_frame() {
+#ifndef __EMSCRIPTEN__
+  int fps = idle                             ? pacing.idle_fps
+            : pacing.mode == PACING_TARGET_FPS ? pacing.target_fps
+                                               : 0;
+  if (fps <= 0)
+    return; // Buffer swap is already paced by vsync
+
+  double period = 1.0 / fps;
+  double now = GetTime();
+  next_frame_time += period;
+  if (next_frame_time < now - period)
+    next_frame_time = now; // Fell behind, don't try to catch up
+
+  double sleep_time = next_frame_time - now - pacing.spin_tail;
+  if (sleep_time > 0.0)
+    WaitTime(sleep_time);
+  while (GetTime() < next_frame_time) {
+  }
+#endif
+}
+
+// Playback only unless capture is asked for: opening the microphone prompts
+// for permission and adds input latency to sessions that never use it.
+// rate 0 takes the device's native rate, so miniaudio never resamples.
+static bool open_audio_device(bool capture, ma_uint32 rate) {
+  ma_device_config deviceConfig = ma_device_config_init(
+      capture ? ma_device_type_duplex : ma_device_type_playback);
   deviceConfig.playback.format = ma_format_f32;
   deviceConfig.playback.channels = CHANNELS;
-  deviceConfig.sampleRate = SAMPLE_RATE;
+  deviceConfig.capture.format = ma_format_f32;
+  deviceConfig.capture.channels = 1;
+  deviceConfig.sampleRate = rate;
   deviceConfig.dataCallback = audio_callback;
 
+  ma_result result = ma_device_init(NULL, &deviceConfig, &device);
+  if (result != MA_SUCCESS && capture) {
+    // No capture device, carry on playback-only
+    deviceConfig.deviceType = ma_device_type_playback;
+    result = ma_device_init(NULL, &deviceConfig, &device);
+  }
+  return result == MA_SUCCESS;
+}
+
+// The first time V asks for the vocoder without an input file, reopen the
+// device in duplex mode. The rate is kept so nothing else has to re-init.
+static void enable_vocoder() {
+  static bool capture_requested = false;
+  if (vocoder_source() == VOCODER_SOURCE_NONE && !capture_requested) {
+    capture_requested = true;
+    ma_device_uninit(&device);
+    if (!open_audio_device(true, (ma_uint32)sampleRate))
+      return;
+    vocoder_init(device.type == ma_device_type_duplex);
+    if (ma_device_start(&device) != MA_SUCCESS)
+      return;
+  }
+  vocoder_set_enabled(true);
+}
+
+bool core_init_window(const char *title) {
+  // A WAV file stands in for the microphone when present, so the vocoder
+  // also runs headless
+  vocoder_open_input(VOCODER_INPUT_PATH);
+  granular_open_source(GRANULAR_SOURCE_PATH);
+
   init_globalControls(&globalControls);
 
   vec2 center = {WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2};
 
   init_rope(&rope, center, (vec2){center.x, center.x + 200}, GRAY);
+  update_synth_controls();
+
+  // Restore the last saved session before any audio is rendered
+  if (FileExists(PRESET_PATH))
+    preset_load(PRESET_PATH);
 
-  if (ma_device_init(NULL, &deviceConfig, &device) != MA_SUCCESS) {
+  // Drum kit for the rhythm track, mapped before the audio thread starts
+  if (sampler_load_kit(SAMPLER_KIT_PATH) > 0)
+    Instruments[1].voiceType = VOICE_SAMPLER;
+
+  if (!open_audio_device(false, 0)) {
     return -1;
   }
 
+  // Everything rate-dependent derives from this before the first callback
+  sampleRate = (float)device.sampleRate;
+  spectrum_init();
+  vocoder_init(false);
+  granular_init();
+
   if (ma_device_start(&device) != MA_SUCCESS) {
     ma_device_uninit(&device);
     return -1;
   }
 
   // Initialize window and graphics
+  if (pacing.mode == PACING_VSYNC)
+    SetConfigFlags(FLAG_VSYNC_HINT);
   InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, title);
-  // SetTargetFPS(60);
+  // No SetTargetFPS: wait_for_next_frame does the pacing
+  next_frame_time = GetTime();
   return true;
 }
 
 void core_close_window() {
   ma_device_uninit(&device);
+  recorder_stop();
+  spectrum_shutdown();
+  vocoder_shutdown();
+  granular_shutdown();
+  preset_shutdown();
+  sampler_shutdown();
+  unload_static_layers();
   CloseWindow();
 }
 
@@ -71,41 +229,113 @@ void core_execute_loop() {
   if (IsKeyPressed(KEY_FOUR))
     Instruments[3].volume = Instruments[3].volume == 0.0f ? 0.5f : 0.0f;
 
+  if (IsKeyPressed(KEY_V)) {
+    if (vocoder_enabled())
+      vocoder_set_enabled(false);
+    else
+      enable_vocoder();
+  }
+
+  if (IsKeyPressed(KEY_G))
+    granular_set_enabled(!granular_enabled());
+
+  // Lead unison stack: 1, 2, 4, 8, 16, back to 1
+  if (IsKeyPressed(KEY_U))
+    Instruments[0].unison = Instruments[0].unison >= UNISON_MAX_VOICES
+                                ? 1
+                                : Instruments[0].unison * 2;
+
+  // Switch between vsync and the sleep-and-spin frame limiter
+  if (IsKeyPressed(KEY_P)) {
+    FramePacing next = pacing;
+    next.mode = pacing.mode == PACING_VSYNC ? PACING_TARGET_FPS : PACING_VSYNC;
+    core_set_frame_pacing(next);
+  }
+
+  if (IsKeyPressed(KEY_F5))
+    preset_save(PRESET_PATH);
+  if (IsKeyPressed(KEY_F9))
+    preset_load(PRESET_PATH);
+  preset_collect();
+
+  if (IsKeyPressed(KEY_R)) {
+    if (recorder_is_recording()) {
+      recorder_stop();
+    } else {
+      // First unused file name, so earlier takes are never overwritten
+      for (int take = 0; take < 1000; take++) {
+        const char *path = TextFormat(RECORDER_PATH_FORMAT, take);
+        if (!FileExists(path)) {
+          recorder_start(path, RECORDER_FORMAT);
+          break;
+        }
+      }
+    }
+  }
+  recorder_update();
+
   globalControls.physics_time += GetFrameTime();
   globalControls.beat_time += GetFrameTime();
   globalControls.sub_beat_time += GetFrameTime();
 
   if (globalControls.beat_time >= 60.0f / globalControls.bpm) {
     globalControls.beat_time = 0;
-    globalControls.beat_triggered = true;
+    synth_trigger_beat();
   }
 
   if (globalControls.sub_beat_time >= 60.0f / globalControls.bpm / SUB_BEATS) {
     globalControls.sub_beat_time = 0;
-    globalControls.sub_beat_triggered = true;
+    synth_trigger_sub_beat();
   }
 
   if (globalControls.physics_time >= 1.0f / 60.0f) {
     globalControls.physics_time = 0;
-    update_rope(&rope);
+    update_rope(&rope, GetMousePosition(),
+                IsMouseButtonDown(MOUSE_LEFT_BUTTON));
   }
 
   rope_bpm_controller(&rope, &globalControls);
+  update_synth_controls();
+  spectrum_update(GetFrameTime());
 
   // Draw
   BeginDrawing();
   ClearBackground(RAYWHITE);
 
-  draw_note_grid(rope.start, rope.end);
+  draw_static_layers();
   // draw_horizontal_waveforms();
   draw_circular_waveforms();
+  draw_spectrum();
 
   draw_rope(&rope);
 
   DrawText(TextFormat("Modulator Freq: %.1f Hz", Instruments[0].modulatorFreq),
            10, 70, 20, BLACK);
-  DrawText("Press: 1, 2, 3, or 4", 10, 100, 20, BLACK);
+  // Row 100 holds the cached key hint
+  DrawText(TextFormat("Unison: %d", Instruments[0].unison), 10, 130, 20,
+           BLACK);
+  DrawText(TextFormat("DSP: %s (%.0f%%)", governor_tier_name(governor_tier()),
+                      governor_load() * 100.0f),
+           10, 40, 20, BLACK);
+  if (vocoder_enabled()) {
+    DrawText(TextFormat("Vocoder: %s", vocoder_source_name()), 10, 190, 20,
+             BLACK);
+  }
+  if (granular_enabled()) {
+    DrawText(TextFormat("Grains: %d (%s)", granular_active_grains(),
+                        granular_source_name()),
+             10, 220, 20, BLACK);
+  }
+  if (recorder_is_recording()) {
+    DrawText(TextFormat("REC %.1fs (dropped %llu)",
+                        recorder_frames_written() / sampleRate,
+                        (unsigned long long)recorder_dropped_frames()),
+             10, 160, 20, RED);
+  }
   DrawFPS(10, 10);
 
   EndDrawing();
+
+  update_idle_state();
+  wait_for_next_frame();
 }
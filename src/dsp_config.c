@@ -0,0 +1,27 @@
+#include "dsp_config.h"
+
+int constSequence[SEQ_SIZE] = {
+    A3, A3, A3, A3, A3, A3, A3, A3,
+};
+
+int testSequence[SEQ_SIZE] = {
+    A3, Af3, B3, C4, D4, E4, F4, G4,
+};
+
+int pentatonicSequence[SEQ_SIZE] = {C3, D3, F3, G3, Af3, C4, D4, F4};
+
+int bassSequence[SEQ_SIZE] = {C2, D2, F2, G2, Af2, C3, D3, F3};
+
+int arpeggioSequence[SEQ_SIZE] = {C4, D4, F4, G4, Af4, C5, D5, F5};
+
+// pentatonic scale in order
+// C–D–F–G–B♭–C
+int pentatonicScale[SCALE_SIZE] = {C3, D3, F3, G3, Af3, C4, D4, F4, G4, Af4};
+
+float sampleRate = DEFAULT_SAMPLE_RATE;
+
+float lerp1D(float a, float b, float t) { return a + t * (b - a); }
+
+float midi_to_freq(int midi) {
+  return powf(2.0f, (midi - 69) / 12.0f) * 440.0f;
+}
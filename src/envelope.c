@@ -0,0 +1,108 @@
+#include "envelope.h"
+
+// Overshoot ratios: a large one keeps the attack close to linear, a small one
+// gives decay and release their exponential shape.
+#define ENV_ATTACK_RATIO 0.3f
+#define ENV_DECAY_RATIO 0.0001f
+
+static float segment_coef(float seconds, float ratio) {
+  float samples = seconds * sampleRate;
+  if (samples <= 0.0f)
+    return 0.0f; // Jump straight to the target on the next sample
+  return expf(-logf((1.0f + ratio) / ratio) / samples);
+}
+
+static void enter_stage(Envelope *env, int stage) {
+  env->stage = stage;
+  switch (stage) {
+  case ENV_DECAY:
+    env->coef = env->decay_coef;
+    env->base = env->decay_base;
+    env->target = env->sustain;
+    break;
+  case ENV_SUSTAIN:
+  case ENV_IDLE:
+    env->coef = 1.0f;
+    env->base = 0.0f;
+    break;
+  default:
+    break;
+  }
+}
+
+// Clamp to the segment target and move on to the following stage
+static void finish_stage(Envelope *env) {
+  env->level = env->target;
+  switch (env->stage) {
+  case ENV_ATTACK:
+    enter_stage(env, ENV_DECAY);
+    break;
+  case ENV_DECAY:
+    enter_stage(env, env->sustain > 0.0f ? ENV_SUSTAIN : ENV_IDLE);
+    break;
+  case ENV_RELEASE:
+    enter_stage(env, ENV_IDLE);
+    break;
+  }
+}
+
+static bool stage_done(const Envelope *env, float level) {
+  return env->stage == ENV_ATTACK ? level >= env->target
+                                  : level <= env->target;
+}
+
+void envelope_gate_on(Envelope *env, const EnvControls *envControls) {
+  if (!env || !envControls)
+    return;
+
+  // Decay segment is fixed for the whole note, so prepare it up front
+  env->sustain = fminf(fmaxf(envControls->sustain, 0.0f), 1.0f);
+  env->decay_coef = segment_coef(envControls->decay, ENV_DECAY_RATIO);
+  env->decay_base =
+      (env->sustain - ENV_DECAY_RATIO) * (1.0f - env->decay_coef);
+
+  // Retrigger from the current level so overlapping notes don't click
+  env->stage = ENV_ATTACK;
+  env->coef = segment_coef(envControls->attack, ENV_ATTACK_RATIO);
+  env->base = (1.0f + ENV_ATTACK_RATIO) * (1.0f - env->coef);
+  env->target = 1.0f;
+}
+
+void envelope_gate_off(Envelope *env, const EnvControls *envControls) {
+  if (!env || !envControls || env->stage == ENV_IDLE)
+    return;
+
+  env->stage = ENV_RELEASE;
+  env->coef = segment_coef(envControls->release, ENV_DECAY_RATIO);
+  env->base = -ENV_DECAY_RATIO * (1.0f - env->coef);
+  env->target = 0.0f;
+}
+
+void envelope_render(Envelope *env, float *out, int frames) {
+  int i = 0;
+  while (i < frames) {
+    if (env->stage == ENV_IDLE || env->stage == ENV_SUSTAIN) {
+      float level = env->level;
+      for (; i < frames; i++)
+        out[i] = level;
+      return;
+    }
+
+    // Run the current segment in registers until it ends or the block does
+    float level = env->level;
+    float coef = env->coef;
+    float base = env->base;
+    for (; i < frames; i++) {
+      level = base + level * coef;
+      if (stage_done(env, level))
+        break;
+      out[i] = level;
+    }
+    env->level = level;
+
+    if (i < frames) {
+      finish_stage(env);
+      out[i++] = env->level;
+    }
+  }
+}
@@ -0,0 +1,87 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L // clock_gettime, nanosleep
+#endif
+
+#include "governor.h"
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Written by the audio thread, read by the render thread for display
+static atomic_int current_tier = QUALITY_FULL;
+static atomic_int load_permille = 0;
+
+// Audio-thread state
+static float smoothed_load = 0.0f;
+static int overloaded_periods = 0;
+static int relaxed_periods = 0;
+
+double governor_now() {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if (!frequency.QuadPart)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / frequency.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+// Compare the DSP time of one device period with the time it represents.
+// Stepping down reacts within a few periods; stepping up needs a long calm
+// stretch so the governor doesn't oscillate around a threshold.
+void governor_update(double start_time, uint32_t frames, float sample_rate) {
+  if (frames == 0 || sample_rate <= 0.0f)
+    return;
+
+  double budget = frames / (double)sample_rate;
+  float load = (float)((governor_now() - start_time) / budget);
+  smoothed_load += GOVERNOR_SMOOTHING * (load - smoothed_load);
+  atomic_store_explicit(&load_permille, (int)(smoothed_load * 1000.0f),
+                        memory_order_relaxed);
+
+  int tier = atomic_load_explicit(&current_tier, memory_order_relaxed);
+  if (smoothed_load > GOVERNOR_HIGH_LOAD) {
+    relaxed_periods = 0;
+    if (++overloaded_periods >= GOVERNOR_DOWN_PERIODS &&
+        tier < QUALITY_TIER_COUNT - 1) {
+      tier++;
+      overloaded_periods = 0;
+    }
+  } else if (smoothed_load < GOVERNOR_LOW_LOAD) {
+    overloaded_periods = 0;
+    if (++relaxed_periods >= GOVERNOR_UP_PERIODS && tier > QUALITY_FULL) {
+      tier--;
+      relaxed_periods = 0;
+    }
+  } else {
+    overloaded_periods = 0;
+    relaxed_periods = 0;
+  }
+  atomic_store_explicit(&current_tier, tier, memory_order_relaxed);
+}
+
+int governor_tier() {
+  return atomic_load_explicit(&current_tier, memory_order_relaxed);
+}
+
+float governor_load() {
+  return atomic_load_explicit(&load_permille, memory_order_relaxed) / 1000.0f;
+}
+
+const char *governor_tier_name(int tier) {
+  static const char *names[QUALITY_TIER_COUNT] = {"full", "cheap filter",
+                                                  "fewer voices", "bypass"};
+  if (tier < 0 || tier >= QUALITY_TIER_COUNT)
+    return "unknown";
+  return names[tier];
+}
@@ -0,0 +1,217 @@
+#include "granular.h"
+#include "sampler.h"
+#include <stdatomic.h>
+
+#define GRANULAR_HISTORY_MASK (GRANULAR_HISTORY_SIZE - 1)
+
+static Grain pool[GRANULAR_MAX_GRAINS];
+static Grain *free_grains = NULL;
+static Grain *active_grains = NULL;
+static int active_count = 0;               // Audio thread only
+static atomic_int published_count = 0; // For the render thread
+static int grain_limit = GRANULAR_MAX_GRAINS;
+static float countdown = 0.0f; // Frames until the next grain starts
+static uint32_t noise_state = 0x6C078965u;
+
+static float window_table[GRANULAR_WINDOW_SIZE + 1]; // Guard for lerp
+static float pan_left[GRANULAR_PAN_STEPS];
+static float pan_right[GRANULAR_PAN_STEPS];
+
+static float history[GRANULAR_HISTORY_SIZE];
+static uint32_t history_write = 0;
+static Sample source = {0};
+static bool has_source = false;
+static atomic_bool enabled = false;
+
+static uint32_t next_random() {
+  noise_state ^= noise_state << 13;
+  noise_state ^= noise_state >> 17;
+  noise_state ^= noise_state << 5;
+  return noise_state;
+}
+
+static float random_unit() {
+  return (next_random() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Called before the audio device starts, like the sampler kit
+bool granular_open_source(const char *path) {
+  has_source = sample_open(&source, path);
+  return has_source;
+}
+
+// The only transcendental maths: tables built once before audio starts
+void granular_init() {
+  for (int i = 0; i <= GRANULAR_WINDOW_SIZE; i++) {
+    window_table[i] =
+        0.5f - 0.5f * cosf(2.0f * PI * i / GRANULAR_WINDOW_SIZE);
+  }
+  for (int i = 0; i < GRANULAR_PAN_STEPS; i++) {
+    float angle = 0.5f * PI * i / (GRANULAR_PAN_STEPS - 1);
+    pan_left[i] = cosf(angle);
+    pan_right[i] = sinf(angle);
+  }
+
+  free_grains = NULL;
+  for (int i = GRANULAR_MAX_GRAINS - 1; i >= 0; i--) {
+    pool[i].next = free_grains;
+    free_grains = &pool[i];
+  }
+  active_grains = NULL;
+  active_count = 0;
+  atomic_store(&published_count, 0);
+  countdown = 0.0f;
+}
+
+void granular_set_enabled(bool value) { atomic_store(&enabled, value); }
+
+bool granular_enabled() { return atomic_load(&enabled); }
+
+const char *granular_source_name() {
+  return has_source ? "sample" : "history";
+}
+
+// Running grains are left to finish; only new ones respect the limit
+void granular_set_grain_limit(int limit) {
+  if (limit < 1)
+    limit = 1;
+  if (limit > GRANULAR_MAX_GRAINS)
+    limit = GRANULAR_MAX_GRAINS;
+  grain_limit = limit;
+}
+
+int granular_active_grains() { return atomic_load(&published_count); }
+
+void granular_capture(const float *in, int frames) {
+  for (int i = 0; i < frames; i++) {
+    history[(history_write + i) & GRANULAR_HISTORY_MASK] = in[i];
+  }
+  history_write += frames;
+}
+
+static void spawn_grain(const GranularControls *controls, int offset,
+                        float length) {
+  if (!free_grains || active_count >= grain_limit)
+    return; // Pool exhausted, skip this grain rather than allocate
+  Grain *grain = free_grains;
+  free_grains = grain->next;
+
+  // Read span of the grain in source frames
+  float span = length * controls->pitch;
+  float position = controls->position;
+  if (has_source) {
+    float rate_scale = source.sample_rate / sampleRate;
+    float usable = source.frame_count - 2 - span * rate_scale;
+    grain->index = (uint32_t)(fmaxf(usable, 0.0f) * position);
+    grain->rate = controls->pitch * rate_scale;
+  } else {
+    // Start far enough back that even a sped-up grain stays behind the
+    // write head
+    float oldest = GRANULAR_HISTORY_SIZE - AUDIO_BLOCK_SIZE - span;
+    float back = span + AUDIO_BLOCK_SIZE + 2 + (oldest - span) * position;
+    grain->index = history_write + offset - (uint32_t)back;
+    grain->rate = controls->pitch;
+  }
+  grain->frac = 0.0f;
+  grain->window = 0.0f;
+  grain->window_step = GRANULAR_WINDOW_SIZE / length;
+
+  int pan = next_random() % GRANULAR_PAN_STEPS;
+  grain->gain_left = pan_left[pan];
+  grain->gain_right = pan_right[pan];
+  grain->offset = offset;
+
+  grain->next = active_grains;
+  active_grains = grain;
+  active_count++;
+}
+
+// Returns false once the window has run out
+static bool render_grain(Grain *grain, float gain, float *out_left,
+                         float *out_right, int frames) {
+  uint32_t index = grain->index;
+  float frac = grain->frac;
+  float window = grain->window;
+  float left = grain->gain_left * gain;
+  float right = grain->gain_right * gain;
+
+  for (int i = grain->offset; i < frames; i++) {
+    if (window >= GRANULAR_WINDOW_SIZE)
+      return false;
+    int w = (int)window;
+    float shape = window_table[w] +
+                  (window_table[w + 1] - window_table[w]) * (window - w);
+
+    float a, b;
+    if (has_source) {
+      if (index + 1 >= source.frame_count)
+        return false; // Sample shorter than the grain
+      a = sample_read_frame(&source, index);
+      b = sample_read_frame(&source, index + 1);
+    } else {
+      a = history[index & GRANULAR_HISTORY_MASK];
+      b = history[(index + 1) & GRANULAR_HISTORY_MASK];
+    }
+    float sample = (a + (b - a) * frac) * shape;
+    out_left[i] += sample * left;
+    out_right[i] += sample * right;
+
+    frac += grain->rate;
+    uint32_t step = (uint32_t)frac;
+    index += step;
+    frac -= step;
+    window += grain->window_step;
+  }
+
+  grain->index = index;
+  grain->frac = frac;
+  grain->window = window;
+  grain->offset = 0;
+  return true;
+}
+
+void granular_render(const GranularControls *controls, float *out_left,
+                     float *out_right, int frames) {
+  if (atomic_load(&enabled)) {
+    float density = fminf(fmaxf(controls->density, GRANULAR_MIN_DENSITY),
+                          GRANULAR_MAX_DENSITY);
+    float size =
+        fminf(fmaxf(controls->size, GRANULAR_MIN_SIZE), GRANULAR_MAX_SIZE);
+    float length = size * sampleRate;
+    float interval = sampleRate / density;
+
+    // Start each grain on its exact frame, with a little jitter so dense
+    // clouds don't buzz at the grain rate
+    while (countdown < frames) {
+      spawn_grain(controls, (int)countdown, length);
+      countdown += interval * (0.75f + 0.5f * random_unit());
+    }
+    countdown -= frames;
+  }
+
+  // Keep the sum level as grains pile up; one sqrt per block
+  float overlap = fmaxf(active_count, 1.0f);
+  float gain = 1.0f / sqrtf(overlap);
+
+  Grain **link = &active_grains;
+  while (*link) {
+    Grain *grain = *link;
+    if (render_grain(grain, gain, out_left, out_right, frames)) {
+      link = &grain->next;
+    } else {
+      *link = grain->next;
+      grain->next = free_grains;
+      free_grains = grain;
+      active_count--;
+    }
+  }
+  atomic_store_explicit(&published_count, active_count, memory_order_relaxed);
+}
+
+// Only call once the audio device is stopped
+void granular_shutdown() {
+  atomic_store(&enabled, false);
+  if (has_source)
+    sample_close(&source);
+  has_source = false;
+}
@@ -1,5 +1,7 @@
 #include "graphics.h"
+#include "rlgl.h"
 #include "rope.h"
+#include "spectrum.h"
 #include "synth.h"
 #include "utils.h"
 
@@ -72,20 +74,16 @@ void draw_circular_waveforms() {
   }
 }
 
-void draw_note_grid(vec2 rope_start, vec2 rope_end) {
-  Color grid_color = (Color){100, 100, 100, 70};
-
-  vec2 direction = Vector2Subtract(rope_end, rope_start);
-  float angle = atan2f(direction.y, direction.x);
-  float angle_deg = angle * 180 / PI;
+// Label in the same spelling as the Notes enum, e.g. 58 -> "Af3"
+static void note_name(int midi, char *out, int size) {
+  static const char *names[12] = {"C",  "Cs", "D",  "Ds", "E",  "F",
+                                  "Fs", "G",  "Gs", "A",  "Af", "B"};
+  snprintf(out, size, "%s%d", names[midi % 12], midi / 12 - 1);
+}
 
-  // Pentatonic scale setup
+void draw_note_grid() {
+  Color grid_color = (Color){100, 100, 100, 70};
   float step_size = 360.0f / SCALE_SIZE;
-  int index = (int)((angle_deg + 180.0f) / step_size) % SCALE_SIZE;
-  float frequency = midi_to_freq(pentatonicScale[index]);
-
-  char note[SCALE_SIZE][4] = {"C3", "D3", "F3", "G3", "Af3",
-                              "C4", "D4", "F4", "G4", "Af4"};
 
   // Draw cone boundaries and labels
   for (int i = 0; i < SCALE_SIZE; i++) {
@@ -118,11 +116,95 @@ void draw_note_grid(vec2 rope_start, vec2 rope_end) {
     }
 
     // Measure text for proper centering
+    char note[16];
+    note_name(pentatonicScale[i], note, sizeof(note));
     int font_size = 20;
-    Vector2 text_size = MeasureTextEx(GetFontDefault(), note[i], font_size, 1);
+    Vector2 text_size = MeasureTextEx(GetFontDefault(), note, font_size, 1);
 
-    DrawTextPro(GetFontDefault(), note[i], text_pos,
+    DrawTextPro(GetFontDefault(), note, text_pos,
                 (Vector2){text_size.x / 2, text_size.y / 2}, // Center alignment
                 0.0, font_size, 1, grid_color);
   }
 }
+
+// Everything that only changes with the window size or the scale is drawn
+// once into an offscreen layer and blitted each frame.
+static RenderTexture2D static_layer;
+static bool static_layer_loaded = false;
+static bool static_layer_dirty = true;
+static int static_layer_scale[SCALE_SIZE];
+
+void invalidate_static_layers() { static_layer_dirty = true; }
+
+static void render_static_layers() {
+  // Store premultiplied colour with correctly accumulated alpha, so the
+  // translucent grid composites the same as when drawn directly
+  rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE,
+                            RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+  BeginTextureMode(static_layer);
+  ClearBackground(BLANK);
+  BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+  draw_note_grid();
+  DrawText("Press: 1, 2, 3, or 4", 10, 100, 20, BLACK);
+
+  EndBlendMode();
+  EndTextureMode();
+}
+
+void draw_static_layers() {
+  int width = GetScreenWidth();
+  int height = GetScreenHeight();
+  if (!static_layer_loaded || static_layer.texture.width != width ||
+      static_layer.texture.height != height) {
+    if (static_layer_loaded)
+      UnloadRenderTexture(static_layer);
+    static_layer = LoadRenderTexture(width, height);
+    static_layer_loaded = true;
+    static_layer_dirty = true;
+  }
+
+  for (int i = 0; i < SCALE_SIZE; i++) {
+    if (static_layer_scale[i] != pentatonicScale[i]) {
+      static_layer_scale[i] = pentatonicScale[i];
+      static_layer_dirty = true;
+    }
+  }
+
+  if (static_layer_dirty) {
+    render_static_layers();
+    static_layer_dirty = false;
+  }
+
+  // Render textures are stored upside down
+  BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+  DrawTextureRec(static_layer.texture,
+                 (Rectangle){0, 0, (float)width, (float)-height},
+                 (Vector2){0, 0}, WHITE);
+  EndBlendMode();
+}
+
+void unload_static_layers() {
+  if (static_layer_loaded)
+    UnloadRenderTexture(static_layer);
+  static_layer_loaded = false;
+}
+
+void draw_spectrum() {
+  const SpectrumFrame *frame = spectrum_latest();
+  Color bar_color = (Color){100, 100, 100, 70};
+  Color peak_color = (Color){100, 100, 100, 150};
+
+  float bar_width = WINDOW_WIDTH / (float)SPECTRUM_BINS;
+  for (int b = 0; b < SPECTRUM_BINS; b++) {
+    float x = b * bar_width;
+    float height = frame->levels[b] * SPECTRUM_HEIGHT;
+    DrawRectangleRec((Rectangle){x + 1, WINDOW_HEIGHT - height, bar_width - 2,
+                                 height},
+                     bar_color);
+
+    float peak_y = WINDOW_HEIGHT - frame->peaks[b] * SPECTRUM_HEIGHT;
+    DrawLineEx((Vector2){x + 1, peak_y}, (Vector2){x + bar_width - 1, peak_y},
+               2, peak_color);
+  }
+}
@@ -0,0 +1,94 @@
+#include "kernels.h"
+
+// Waveforms as expressions so each kernel inlines its own. Phase is in [0, 1).
+#define SHAPE_SINE(t) sinf(2.0f * PI * (t))
+#define SHAPE_SQUARE(t) ((t) < 0.5f ? 1.0f : -1.0f)
+#define SHAPE_TRIANGLE(t) (1.0f - 4.0f * fabsf((t) - 0.5f))
+#define SHAPE_SAWTOOTH(t) (2.0f * (t) - 1.0f)
+
+// FM and ENV are literal 0/1 and FILTER a FilterModes constant, so the
+// compiler drops the unused paths and each kernel's inner loops are
+// branch-free. Without FM the phase has a closed form, which leaves no
+// loop-carried dependency and lets the shape, volume and envelope pass
+// vectorise. The phase is never negative there, so truncation can stand in
+// for floorf.
+#define DEFINE_RENDER_KERNEL(name, SHAPE, FM, FILTER, ENV)                     \
+  static void name(FMSynth *fmSynth, float *modPhase, ResonantFilter *filter, \
+                   const BiquadCoeffs *coeffs, const float *env, float *out,  \
+                   int frames) {                                              \
+    float phase = fmSynth->phase;                                             \
+    float inc = fmSynth->carrierFreq / sampleRate;                            \
+    float volume = fmSynth->volume;                                           \
+    float mod_phase = *modPhase;                                              \
+    float mod_inc = fmSynth->modulatorFreq / sampleRate;                      \
+    if (FM) {                                                                 \
+      float depth = fmSynth->modIndex * inc;                                  \
+      for (int i = 0; i < frames; i++) {                                      \
+        out[i] = SHAPE(phase) * volume * (ENV ? env[i] : 1.0f);               \
+        phase += inc + sinf(2.0f * PI * mod_phase) * depth;                   \
+        phase -= floorf(phase);                                               \
+        mod_phase += mod_inc;                                                 \
+        mod_phase -= floorf(mod_phase);                                       \
+      }                                                                       \
+    } else {                                                                  \
+      for (int i = 0; i < frames; i++) {                                      \
+        float t = phase + i * inc;                                            \
+        t -= (int)t;                                                          \
+        out[i] = SHAPE(t) * volume * (ENV ? env[i] : 1.0f);                   \
+      }                                                                       \
+      phase += frames * inc;                                                  \
+      phase -= floorf(phase);                                                 \
+      mod_phase += frames * mod_inc;                                          \
+      mod_phase -= floorf(mod_phase);                                         \
+    }                                                                         \
+    if (FILTER == FILTER_BIQUAD)                                              \
+      biquad_process(filter, coeffs, out, frames);                            \
+    else if (FILTER == FILTER_ONE_POLE)                                       \
+      one_pole_process(filter, coeffs, out, frames);                          \
+    fmSynth->phase = phase;                                                   \
+    *modPhase = mod_phase;                                                    \
+  }
+
+#define KERNEL(shape, fm, filter, env) render_##shape##_##fm##_##filter##_##env
+
+#define DEFINE_FM_KERNELS(shape, SHAPE, FM)                                    \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 0, 0), SHAPE, FM, 0, 0)               \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 0, 1), SHAPE, FM, 0, 1)               \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 1, 0), SHAPE, FM, 1, 0)               \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 1, 1), SHAPE, FM, 1, 1)               \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 2, 0), SHAPE, FM, 2, 0)               \
+  DEFINE_RENDER_KERNEL(KERNEL(shape, FM, 2, 1), SHAPE, FM, 2, 1)
+
+#define DEFINE_SHAPE_KERNELS(shape, SHAPE)                                     \
+  DEFINE_FM_KERNELS(shape, SHAPE, 0)                                           \
+  DEFINE_FM_KERNELS(shape, SHAPE, 1)
+
+#define FM_KERNEL_TABLE(shape, fm)                                             \
+  {{KERNEL(shape, fm, 0, 0), KERNEL(shape, fm, 0, 1)},                         \
+   {KERNEL(shape, fm, 1, 0), KERNEL(shape, fm, 1, 1)},                         \
+   {KERNEL(shape, fm, 2, 0), KERNEL(shape, fm, 2, 1)}}
+
+#define SHAPE_KERNEL_TABLE(shape)                                              \
+  {FM_KERNEL_TABLE(shape, 0), FM_KERNEL_TABLE(shape, 1)}
+
+DEFINE_SHAPE_KERNELS(sine, SHAPE_SINE)
+DEFINE_SHAPE_KERNELS(square, SHAPE_SQUARE)
+DEFINE_SHAPE_KERNELS(triangle, SHAPE_TRIANGLE)
+DEFINE_SHAPE_KERNELS(sawtooth, SHAPE_SAWTOOTH)
+
+// Indexed [shape][fm][filter mode][env], in Waveforms/FilterModes order
+static const RenderKernel render_kernels[4][2][FILTER_MODE_COUNT][2] = {
+    SHAPE_KERNEL_TABLE(sine),
+    SHAPE_KERNEL_TABLE(square),
+    SHAPE_KERNEL_TABLE(triangle),
+    SHAPE_KERNEL_TABLE(sawtooth),
+};
+
+RenderKernel select_render_kernel(int shape, bool fm, int filterMode,
+                                  bool env) {
+  if (shape < SINE || shape > SAWTOOTH)
+    shape = SINE;
+  if (filterMode < FILTER_NONE || filterMode >= FILTER_MODE_COUNT)
+    filterMode = FILTER_NONE;
+  return render_kernels[shape][fm][filterMode][env];
+}
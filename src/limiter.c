@@ -0,0 +1,33 @@
+#include "limiter.h"
+#include "denormal.h"
+#include "dsp_config.h"
+
+// Linear up to the knee, then bends smoothly towards 1 with matching slope
+static inline float soft_clip(float x) {
+  float magnitude = fabsf(x);
+  if (magnitude <= LIMITER_KNEE)
+    return x;
+  float over = (magnitude - LIMITER_KNEE) / (1.0f - LIMITER_KNEE);
+  float shaped = LIMITER_KNEE + (1.0f - LIMITER_KNEE) * over / (1.0f + over);
+  return x < 0.0f ? -shaped : shaped;
+}
+
+void limiter_process(Limiter *limiter, float *left, float *right,
+                     int frames) {
+  if (limiter->coef_rate != sampleRate) {
+    limiter->release_coef = expf(-1.0f / (LIMITER_RELEASE * sampleRate));
+    limiter->coef_rate = sampleRate;
+  }
+
+  float envelope = limiter->envelope;
+  float coef = limiter->release_coef;
+  for (int i = 0; i < frames; i++) {
+    float peak = fmaxf(fabsf(left[i]), fabsf(right[i]));
+    envelope = peak > envelope ? peak : peak + coef * (envelope - peak);
+    float gain = envelope > LIMITER_THRESHOLD ? LIMITER_THRESHOLD / envelope
+                                              : 1.0f;
+    left[i] = soft_clip(left[i] * gain);
+    right[i] = soft_clip(right[i] * gain);
+  }
+  limiter->envelope = flush_denormal(envelope);
+}
@@ -8,7 +8,7 @@
 int main(void) {
   core_init_window("Synth");
   #ifdef __EMSCRIPTEN__
-    emscripten_set_main_loop(core_execute_loop, 1000, 1);
+    emscripten_set_main_loop(core_execute_loop, 0, 1); // requestAnimationFrame
   #else
   while (!core_window_should_close()) {
     core_execute_loop();
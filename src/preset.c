@@ -0,0 +1,157 @@
+#include "preset.h"
+#include "mapfile.h"
+#include "rope.h"
+#include "synth.h"
+#include "unison.h"
+#include "utils.h"
+
+_Static_assert(sizeof(InstrumentPreset) == (14 + SEQ_SIZE) * 4,
+               "InstrumentPreset must not contain padding");
+
+typedef struct {
+  MappedFile file;
+  uint32_t epoch; // Audio epoch at which the file became unreachable
+} RetiredPreset;
+
+static MappedFile current_preset = {0};
+static RetiredPreset retired_presets[PRESET_MAX_RETIRED] = {0};
+static int retired_count = 0;
+
+static uint32_t preset_checksum(const SynthPreset *preset) {
+  const uint8_t *bytes = (const uint8_t *)&preset->instruments;
+  size_t length = sizeof(SynthPreset) - offsetof(SynthPreset, instruments);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void preset_capture(SynthPreset *preset) {
+  if (!preset)
+    return;
+  *preset = (SynthPreset){0};
+  preset->magic = PRESET_MAGIC;
+  preset->version = PRESET_VERSION;
+  preset->size = sizeof(SynthPreset);
+
+  for (int j = 0; j < MAX_INSTRUMENTS; j++) {
+    FMSynth *fmSynth = &Instruments[j];
+    InstrumentPreset *instrument = &preset->instruments[j];
+    instrument->carrierFreq = fmSynth->carrierFreq;
+    instrument->carrierShape = fmSynth->carrierShape;
+    instrument->modulatorFreq = fmSynth->modulatorFreq;
+    instrument->modIndex = fmSynth->modIndex;
+    instrument->resonance = fmSynth->resonance;
+    instrument->volume = fmSynth->volume;
+    instrument->envControls = fmSynth->envControls;
+    instrument->unison = fmSynth->unison;
+    instrument->detune = fmSynth->detune;
+    instrument->stereoSpread = fmSynth->stereoSpread;
+    for (int i = 0; i < SEQ_SIZE; i++) {
+      instrument->sequence[i] = fmSynth->sequence[i];
+    }
+  }
+
+  preset->min_bpm = globalControls.min_bpm;
+  preset->max_bpm = globalControls.max_bpm;
+  preset->arp_mode = globalControls.arp_mode;
+  preset->rope_damping = rope.damping;
+  preset->rope_compliance = rope.compliance;
+  preset->checksum = preset_checksum(preset);
+}
+
+const SynthPreset *preset_validate(const void *data, size_t size) {
+  if (!data || size < sizeof(SynthPreset))
+    return NULL;
+
+  const SynthPreset *preset = (const SynthPreset *)data;
+  if (preset->magic != PRESET_MAGIC || preset->version != PRESET_VERSION ||
+      preset->size != sizeof(SynthPreset))
+    return NULL;
+  if (preset->checksum != preset_checksum(preset))
+    return NULL;
+
+  // Reject values that would index out of range on the audio thread
+  for (int j = 0; j < MAX_INSTRUMENTS; j++) {
+    int shape = preset->instruments[j].carrierShape;
+    if (shape < SINE || shape > SAWTOOTH)
+      return NULL;
+    int unison = preset->instruments[j].unison;
+    if (unison < 1 || unison > UNISON_MAX_VOICES)
+      return NULL;
+  }
+  if (preset->arp_mode < UP || preset->arp_mode > RANDOM)
+    return NULL;
+
+  return preset;
+}
+
+bool preset_save(const char *path) {
+  SynthPreset preset;
+  preset_capture(&preset);
+
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+  bool ok = fwrite(&preset, sizeof(preset), 1, file) == 1;
+  return fclose(file) == 0 && ok;
+}
+
+// Unmap presets that no audio callback can still be reading
+void preset_collect() {
+  uint32_t epoch = synth_audio_epoch();
+  int kept = 0;
+  for (int i = 0; i < retired_count; i++) {
+    if (epoch != retired_presets[i].epoch) {
+      unmap_file(&retired_presets[i].file);
+    } else {
+      retired_presets[kept++] = retired_presets[i];
+    }
+  }
+  retired_count = kept;
+}
+
+bool preset_load(const char *path) {
+  preset_collect();
+  if (retired_count == PRESET_MAX_RETIRED)
+    return false;
+
+  MappedFile file;
+  if (!map_file(path, &file))
+    return false;
+
+  const SynthPreset *preset = preset_validate(file.data, file.size);
+  if (!preset) {
+    unmap_file(&file);
+    return false;
+  }
+
+  // Render-thread state is applied here, instrument state by the audio thread
+  globalControls.min_bpm = preset->min_bpm;
+  globalControls.max_bpm = preset->max_bpm;
+  globalControls.arp_mode = preset->arp_mode;
+  rope.damping = preset->rope_damping;
+  rope.compliance = preset->rope_compliance;
+
+  synth_queue_preset(preset);
+
+  // The previous file is unreachable once the swap is done, but a callback
+  // may still be copying from it until the audio epoch moves on
+  if (current_preset.data) {
+    retired_presets[retired_count++] =
+        (RetiredPreset){current_preset, synth_audio_epoch()};
+  }
+  current_preset = file;
+  return true;
+}
+
+// Only call once the audio device is stopped
+void preset_shutdown() {
+  for (int i = 0; i < retired_count; i++) {
+    unmap_file(&retired_presets[i].file);
+  }
+  retired_count = 0;
+  unmap_file(&current_preset);
+}
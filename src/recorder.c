@@ -0,0 +1,215 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L // nanosleep
+#endif
+
+#include "recorder.h"
+#include "denormal.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define RECORDER_SAMPLES (RECORDER_RING_FRAMES * CHANNELS)
+
+// SPSC ring: the audio thread advances write_pos, the writer read_pos
+static float ring[RECORDER_SAMPLES];
+static atomic_uint_fast64_t write_pos = 0;
+static atomic_uint_fast64_t read_pos = 0;
+static atomic_uint_fast64_t dropped_frames = 0;
+static atomic_bool recording = false;
+static atomic_int writes_in_flight = 0; // Callbacks inside recorder_write
+
+// Writer-side state
+static FILE *file = NULL;
+static int record_format = RECORD_F32;
+static uint64_t frames_on_disk = 0;
+static int16_t convert_buffer[RECORDER_CHUNK_FRAMES * CHANNELS];
+
+#ifndef __EMSCRIPTEN__
+static pthread_t writer;
+static atomic_bool writer_running = false;
+#endif
+
+static void write_u16(uint16_t value) {
+  unsigned char bytes[2] = {value & 0xFF, value >> 8};
+  fwrite(bytes, 1, 2, file);
+}
+
+static void write_u32(uint32_t value) {
+  unsigned char bytes[4] = {value & 0xFF, (value >> 8) & 0xFF,
+                            (value >> 16) & 0xFF, value >> 24};
+  fwrite(bytes, 1, 4, file);
+}
+
+// Plain 44-byte header; sizes are patched in when the recording stops
+static void write_wav_header(uint64_t frames) {
+  int bytes_per_sample = record_format == RECORD_S16 ? 2 : 4;
+  uint64_t data_size = frames * CHANNELS * bytes_per_sample;
+  if (data_size > UINT32_MAX - 36)
+    data_size = UINT32_MAX - 36;
+
+  fwrite("RIFF", 1, 4, file);
+  write_u32((uint32_t)(36 + data_size));
+  fwrite("WAVEfmt ", 1, 8, file);
+  write_u32(16);
+  write_u16(record_format == RECORD_S16 ? 1 : 3); // PCM or IEEE float
+  write_u16(CHANNELS);
+  write_u32((uint32_t)sampleRate);
+  write_u32((uint32_t)sampleRate * CHANNELS * bytes_per_sample);
+  write_u16(CHANNELS * bytes_per_sample);
+  write_u16(bytes_per_sample * 8);
+  fwrite("data", 1, 4, file);
+  write_u32((uint32_t)data_size);
+}
+
+static void write_samples(const float *samples, size_t frames) {
+  size_t count = frames * CHANNELS;
+  if (record_format == RECORD_F32) {
+    fwrite(samples, sizeof(float), count, file);
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    float value = fminf(fmaxf(samples[i], -1.0f), 1.0f);
+    convert_buffer[i] = (int16_t)lrintf(value * 32767.0f);
+  }
+  fwrite(convert_buffer, sizeof(int16_t), count, file);
+}
+
+// Move up to one chunk from the ring to disk; returns the frames written
+static size_t drain_chunk(bool flush) {
+  uint64_t read = atomic_load_explicit(&read_pos, memory_order_relaxed);
+  uint64_t available =
+      atomic_load_explicit(&write_pos, memory_order_acquire) - read;
+  if (available == 0 || (!flush && available < RECORDER_CHUNK_FRAMES))
+    return 0;
+  if (available > RECORDER_CHUNK_FRAMES)
+    available = RECORDER_CHUNK_FRAMES;
+
+  size_t start = read % RECORDER_RING_FRAMES;
+  size_t first = RECORDER_RING_FRAMES - start;
+  if (first > available)
+    first = available;
+  write_samples(ring + start * CHANNELS, first);
+  write_samples(ring, available - first);
+
+  frames_on_disk += available;
+  atomic_store_explicit(&read_pos, read + available, memory_order_release);
+  return available;
+}
+
+#ifndef __EMSCRIPTEN__
+static void *recorder_writer(void *arg) {
+  (void)arg;
+  denormals_disable();
+  struct timespec idle = {0, 10 * 1000000L};
+  while (atomic_load(&writer_running)) {
+    if (drain_chunk(false) == 0)
+      nanosleep(&idle, NULL);
+  }
+  while (drain_chunk(true) > 0) {
+  }
+  return NULL;
+}
+#endif
+
+bool recorder_start(const char *path, int format) {
+  if (atomic_load(&recording) || !path)
+    return false;
+
+  file = fopen(path, "wb");
+  if (!file)
+    return false;
+
+  record_format = format;
+  frames_on_disk = 0;
+  write_wav_header(0);
+
+  // Fault the ring in now so the audio thread never takes a page fault
+  memset(ring, 0, sizeof(ring));
+  atomic_store(&read_pos, 0);
+  atomic_store(&write_pos, 0);
+  atomic_store(&dropped_frames, 0);
+
+#ifndef __EMSCRIPTEN__
+  atomic_store(&writer_running, true);
+  if (pthread_create(&writer, NULL, recorder_writer, NULL) != 0) {
+    atomic_store(&writer_running, false);
+    fclose(file);
+    file = NULL;
+    return false;
+  }
+#endif
+  atomic_store(&recording, true);
+  return true;
+}
+
+void recorder_stop() {
+  if (!atomic_exchange(&recording, false))
+    return;
+
+  // A callback that saw recording set may still be copying; once it leaves,
+  // nothing else can reach the ring and the final flush is complete
+  while (atomic_load(&writes_in_flight) > 0) {
+  }
+
+#ifndef __EMSCRIPTEN__
+  atomic_store(&writer_running, false);
+  pthread_join(writer, NULL);
+#else
+  while (drain_chunk(true) > 0) {
+  }
+#endif
+
+  fseek(file, 0, SEEK_SET);
+  write_wav_header(frames_on_disk);
+  fclose(file);
+  file = NULL;
+}
+
+bool recorder_is_recording() { return atomic_load(&recording); }
+
+// Audio thread: at most two memcpys. A block that doesn't fit is dropped
+// and counted rather than waiting on the writer.
+void recorder_write(const float *frames, uint32_t frameCount) {
+  // Announce the write before checking the flag, so recorder_stop either
+  // sees us in flight or we see recording cleared
+  atomic_fetch_add(&writes_in_flight, 1);
+  if (!atomic_load(&recording)) {
+    atomic_fetch_sub(&writes_in_flight, 1);
+    return;
+  }
+
+  uint64_t write = atomic_load_explicit(&write_pos, memory_order_relaxed);
+  uint64_t read = atomic_load_explicit(&read_pos, memory_order_acquire);
+  if (write - read + frameCount > RECORDER_RING_FRAMES) {
+    atomic_fetch_add_explicit(&dropped_frames, frameCount,
+                              memory_order_relaxed);
+    atomic_fetch_sub(&writes_in_flight, 1);
+    return;
+  }
+
+  size_t start = write % RECORDER_RING_FRAMES;
+  size_t first = RECORDER_RING_FRAMES - start;
+  if (first > frameCount)
+    first = frameCount;
+  memcpy(ring + start * CHANNELS, frames, first * CHANNELS * sizeof(float));
+  memcpy(ring, frames + first * CHANNELS,
+         (frameCount - first) * CHANNELS * sizeof(float));
+  atomic_store_explicit(&write_pos, write + frameCount, memory_order_release);
+  atomic_fetch_sub_explicit(&writes_in_flight, 1, memory_order_release);
+}
+
+// Without threads the ring is drained from the render loop
+void recorder_update() {
+#ifdef __EMSCRIPTEN__
+  if (atomic_load(&recording))
+    drain_chunk(true);
+#endif
+}
+
+uint64_t recorder_frames_written() { return atomic_load(&write_pos); }
+
+uint64_t recorder_dropped_frames() { return atomic_load(&dropped_frames); }
@@ -1,4 +1,5 @@
 #include "rope.h"
+#include "waveguide.h"
 
 void init_rope(Rope *rope, vec2 start, vec2 end, Color color) {
   if (!rope)
@@ -7,8 +8,10 @@ void init_rope(Rope *rope, vec2 start, vec2 end, Color color) {
   rope->end_prev = end;
   rope->end = end;
   rope->color = color;
-  rope->damping = 0.99f;  // Damping factor (energy loss)
-  rope->stiffness = 1.0f; // Spring stiffness
+  rope->damping = 0.99f; // Damping factor (energy loss)
+  rope->compliance = ROPE_COMPLIANCE;
+  rope->iterations = 0;
+  rope->still_steps = 0;
 
   // Initialize points along the rope
   float dx = (end.x - start.x) / (ROPE_POINTS - 1);
@@ -20,32 +23,72 @@ void init_rope(Rope *rope, vec2 start, vec2 end, Color color) {
   }
 }
 
-void solve_rope_constraints(Rope *rope) {
+// Largest XPBD residual |C + alpha_tilde * lambda| over all segments
+static float rope_residual(Rope *rope, float alpha_tilde) {
+  float target_dist = ROPE_REST_LENGTH / (float)(ROPE_POINTS - 1);
+  float max_residual = 0.0f;
+  for (int i = 0; i < ROPE_POINTS - 1; i++) {
+    float dist = Vector2Distance(rope->points[i + 1], rope->points[i]);
+    float residual = dist - target_dist + alpha_tilde * rope->lambdas[i];
+    max_residual = fmaxf(max_residual, fabsf(residual));
+  }
+  return max_residual;
+}
+
+// One XPBD pass, returning the residual left after it. Segments share
+// points, so a Gauss-Seidel sweep only moves a correction one link per pass
+// and never settles under gravity. The chain's system is tridiagonal
+// instead, so each pass solves every segment together in O(n) (Thomas).
+float solve_rope_constraints(Rope *rope, float alpha_tilde) {
   if (!rope)
-    return;
+    return 0.0f;
   // Keep first point fixed
   rope->points[0] = rope->start;
 
-  // Solve distance constraints
-  for (int i = 0; i < ROPE_POINTS - 1; i++) {
+  enum { SEGMENTS = ROPE_POINTS - 1 };
+  float target_dist = ROPE_REST_LENGTH / (float)SEGMENTS;
+  vec2 normals[SEGMENTS];
+  float upper[SEGMENTS];
+  float rhs[SEGMENTS];
+
+  for (int i = 0; i < SEGMENTS; i++) {
     vec2 delta = Vector2Subtract(rope->points[i + 1], rope->points[i]);
     float dist = Vector2Length(delta);
-    float target_dist = ROPE_REST_LENGTH / (float)(ROPE_POINTS - 1);
+    normals[i] = dist > 0.0001f ? Vector2Scale(delta, 1.0f / dist)
+                                : Vector2Zero();
+    rhs[i] = -(dist - target_dist) - alpha_tilde * rope->lambdas[i];
+  }
 
-    if (dist > 0.0001f) {
-      float difference = (dist - target_dist) / dist;
-      vec2 correction = Vector2Scale(delta, 0.5f * difference);
-      correction = Vector2Scale(correction, rope->stiffness);
+  // Forward elimination; the first point is pinned, every other weighs 1
+  float prev_upper = 0.0f;
+  for (int i = 0; i < SEGMENTS; i++) {
+    float w0 = i > 0 ? 1.0f : 0.0f;
+    float diag = w0 + 1.0f + alpha_tilde;
+    float lower = i > 0 ? -Vector2DotProduct(normals[i - 1], normals[i]) : 0.0f;
+    float pivot = diag - lower * prev_upper;
+    upper[i] = i < SEGMENTS - 1
+                   ? -Vector2DotProduct(normals[i], normals[i + 1]) / pivot
+                   : 0.0f;
+    rhs[i] = (rhs[i] - (i > 0 ? lower * rhs[i - 1] : 0.0f)) / pivot;
+    prev_upper = upper[i];
+  }
+  // Back substitution leaves the multiplier steps in rhs
+  for (int i = SEGMENTS - 2; i >= 0; i--) {
+    rhs[i] -= upper[i] * rhs[i + 1];
+  }
 
-      if (i > 0) {
-        rope->points[i] = Vector2Add(rope->points[i], correction);
-      }
-      rope->points[i + 1] = Vector2Subtract(rope->points[i + 1], correction);
-    }
+  for (int i = 0; i < SEGMENTS; i++) {
+    rope->lambdas[i] += rhs[i];
+    vec2 correction = Vector2Scale(normals[i], rhs[i]);
+    if (i > 0)
+      rope->points[i] = Vector2Subtract(rope->points[i], correction);
+    rope->points[i + 1] = Vector2Add(rope->points[i + 1], correction);
   }
+  return rope_residual(rope, alpha_tilde);
 }
 
-void update_rope(Rope *rope) {
+// pointer is the mouse position, passed in so the physics runs headless
+void update_rope(Rope *rope, vec2 pointer, bool pointer_down) {
   if (!rope)
     return;
   vec2 gravity = (vec2){0.0f, 800.0f}; // Apply downward gravity
@@ -74,9 +117,17 @@ void update_rope(Rope *rope) {
         Vector2Add(rope->points[i], Vector2Scale(rope->velocities[i], dt));
   }
 
-  // Solve constraints multiple times for stability
-  for (int iter = 0; iter < ROPE_ITERATIONS; iter++) {
-    solve_rope_constraints(rope);
+  // Iterate until the residual is within tolerance. A resting rope only
+  // has to take back one step of gravity, which a single pass does.
+  float alpha_tilde = rope->compliance / (dt * dt);
+  for (int i = 0; i < ROPE_POINTS - 1; i++) {
+    rope->lambdas[i] = 0.0f;
+  }
+  rope->iterations = 0;
+  while (rope->iterations < ROPE_MAX_ITERATIONS) {
+    rope->iterations++;
+    if (solve_rope_constraints(rope, alpha_tilde) < ROPE_TOLERANCE)
+      break;
   }
 
   // Update velocities based on constrained positions and apply damping
@@ -87,11 +138,11 @@ void update_rope(Rope *rope) {
   }
 
   // Mouse interaction
-  vec2 mouse_pos = GetMousePosition();
+  vec2 mouse_pos = pointer;
   static bool was_dragging = false;
   static vec2 drag_start_pos;
 
-  if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+  if (pointer_down) {
     float grab_radius = 100.0f;
     if (CheckCollisionPointCircle(mouse_pos, rope->points[ROPE_POINTS - 1],
                                   grab_radius) ||
@@ -108,12 +159,34 @@ void update_rope(Rope *rope) {
     vec2 drag_vector = Vector2Subtract(mouse_pos, drag_start_pos);
     rope->velocities[ROPE_POINTS - 1] = Vector2Scale(drag_vector, 1.0f / dt);
     was_dragging = false;
+
+    // Pluck the string: release speed sets how hard, stretch how bright
+    float speed = Vector2Length(rope->velocities[ROPE_POINTS - 1]);
+    float tension = Vector2Distance(rope->start, mouse_pos) / MAX_ROPE_LENGTH;
+    waveguide_pluck(freq_from_rope_dir(rope),
+                    0.3f + 0.7f * fminf(speed / WAVEGUIDE_MAX_SPEED, 1.0f),
+                    tension);
   }
 
   // Maintain fixed starting point (optional)
   rope->end = rope->points[ROPE_POINTS - 1];
   rope->points[0] = rope->start;
   rope->velocities[0] = Vector2Zero();
+
+  // Rest is judged on how far the points moved this step, not on the
+  // solver's velocities: a hanging chain keeps a sub-pixel zig-zag near the
+  // pin that never dies down. Separate rest and wake distances keep the
+  // state from flickering around a single threshold.
+  float max_moved = 0.0f;
+  for (int i = 0; i < ROPE_POINTS; i++) {
+    float moved = Vector2Distance(rope->points[i], old_points[i]);
+    max_moved = fmaxf(max_moved, moved);
+  }
+  if (max_moved > ROPE_WAKE_DISTANCE)
+    rope->still_steps = 0;
+  else if (max_moved < ROPE_REST_DISTANCE &&
+           rope->still_steps < ROPE_REST_STEPS)
+    rope->still_steps++;
 }
 
 void draw_rope(Rope *rope) {
@@ -127,6 +200,12 @@ void draw_rope(Rope *rope) {
   }
 }
 
+bool rope_is_at_rest(Rope *rope) {
+  if (!rope)
+    return true;
+  return rope->still_steps >= ROPE_REST_STEPS;
+}
+
 float freq_from_rope_dir(Rope *rope) {
   if (!rope)
     return 0.0f;
@@ -154,8 +233,8 @@ void rope_bpm_controller(Rope *rope, GlobalControls *globalControls) {
   if (!rope || !globalControls)
     return;
   // Update bpm based on rope length
-  float max_bpm = MAX_BPM;
-  float min_bpm = MIN_BPM;
+  float max_bpm = globalControls->max_bpm;
+  float min_bpm = globalControls->min_bpm;
   float max_rope_length = MAX_ROPE_LENGTH;
 
   float rope_length = Vector2Distance(rope->end, rope->start);
@@ -0,0 +1,217 @@
+#include "sampler.h"
+#include <string.h>
+
+static Sample slots[SAMPLER_MAX_SLOTS] = {0};
+static int slot_count = 0;
+static SamplerVoice voices[SAMPLER_MAX_VOICES] = {0};
+static uint32_t trigger_count = 0;
+static int voice_limit = SAMPLER_MAX_VOICES;
+
+static uint16_t read_u16(const unsigned char *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_u32(const unsigned char *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// Walk the RIFF chunks and point the sample at the PCM inside the mapping
+static bool parse_wav(Sample *sample) {
+  const unsigned char *bytes = sample->file.data;
+  size_t size = sample->file.size;
+  if (size < 12 || memcmp(bytes, "RIFF", 4) != 0 ||
+      memcmp(bytes + 8, "WAVE", 4) != 0)
+    return false;
+
+  int audio_format = 0;
+  int bits = 0;
+  uint32_t data_size = 0;
+  size_t offset = 12;
+  while (offset + 8 <= size) {
+    const unsigned char *chunk = bytes + offset;
+    uint32_t chunk_size = read_u32(chunk + 4);
+    if (chunk_size > size - offset - 8)
+      chunk_size = (uint32_t)(size - offset - 8); // Truncated file
+
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+      audio_format = read_u16(chunk + 8);
+      sample->channels = read_u16(chunk + 10);
+      sample->sample_rate = (float)read_u32(chunk + 12);
+      bits = read_u16(chunk + 22);
+      if (audio_format == 0xFFFE && chunk_size >= 40)
+        audio_format = read_u16(chunk + 32); // WAVE_FORMAT_EXTENSIBLE
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      sample->data = chunk + 8;
+      data_size = chunk_size;
+    } else if (memcmp(chunk, "smpl", 4) == 0 && chunk_size >= 60 &&
+               read_u32(chunk + 36) > 0) {
+      sample->looped = true;
+      sample->loop_start = read_u32(chunk + 52);
+      sample->loop_end = read_u32(chunk + 56) + 1; // Stored inclusive
+    }
+    offset += 8 + chunk_size + (chunk_size & 1);
+  }
+
+  if (audio_format == 1 && bits == 16) {
+    sample->format = SAMPLE_S16;
+  } else if (audio_format == 3 && bits == 32) {
+    sample->format = SAMPLE_F32;
+  } else {
+    return false;
+  }
+  if (!sample->data || sample->channels < 1 || sample->channels > 2 ||
+      sample->sample_rate <= 0.0f)
+    return false;
+
+  sample->frame_count = data_size / (sample->channels * (bits / 8));
+  if (sample->frame_count < 2)
+    return false;
+  if (sample->looped && (sample->loop_end > sample->frame_count ||
+                         sample->loop_start + 1 >= sample->loop_end))
+    sample->looped = false;
+  return true;
+}
+
+// Map a WAV file and point the sample at its PCM. Called before the audio
+// device starts; the audio thread never maps files.
+bool sample_open(Sample *sample, const char *path) {
+  *sample = (Sample){0};
+  if (!map_file(path, &sample->file))
+    return false;
+  if (!parse_wav(sample)) {
+    unmap_file(&sample->file);
+    return false;
+  }
+
+  // Keep the attack resident so a hit never waits on the disk, and let the
+  // OS read the tail ahead in the background
+  size_t data_offset = sample->data - (const unsigned char *)sample->file.data;
+  prefault_mapped_file(&sample->file, data_offset, SAMPLER_PREFAULT_BYTES);
+  return true;
+}
+
+void sample_close(Sample *sample) {
+  unmap_file(&sample->file);
+  *sample = (Sample){0};
+}
+
+bool sampler_load(int slot, const char *path) {
+  if (slot < 0 || slot >= SAMPLER_MAX_SLOTS)
+    return false;
+
+  Sample sample;
+  if (!sample_open(&sample, path))
+    return false;
+
+  sample_close(&slots[slot]);
+  slots[slot] = sample;
+  if (slot >= slot_count)
+    slot_count = slot + 1;
+  return true;
+}
+
+int sampler_load_kit(const char *pattern) {
+  int loaded = 0;
+  for (int slot = 0; slot < SAMPLER_MAX_SLOTS; slot++) {
+    char path[256];
+    snprintf(path, sizeof(path), pattern, slot);
+    if (!sampler_load(slot, path))
+      break;
+    loaded++;
+  }
+  return loaded;
+}
+
+int sampler_slot_count() { return slot_count; }
+
+// New hits only use the first `limit` voices; ones already sounding above
+// the limit are left to finish
+void sampler_set_voice_limit(int limit) {
+  if (limit < 1)
+    limit = 1;
+  if (limit > SAMPLER_MAX_VOICES)
+    limit = SAMPLER_MAX_VOICES;
+  voice_limit = limit;
+}
+
+void sampler_trigger(int slot, float pitch, float gain) {
+  if (slot < 0 || slot >= slot_count || !slots[slot].data)
+    return;
+
+  // Reuse a free voice, or steal the oldest one. A looped sample retriggered
+  // in the same slot replaces its previous voice instead of piling up.
+  SamplerVoice *voice = &voices[0];
+  for (int v = 0; v < voice_limit; v++) {
+    SamplerVoice *candidate = &voices[v];
+    if (!candidate->active ||
+        (candidate->slot == slot && slots[slot].looped)) {
+      voice = candidate;
+      break;
+    }
+    if (candidate->age < voice->age)
+      voice = candidate;
+  }
+
+  const Sample *sample = &slots[slot];
+  *voice = (SamplerVoice){.sample = sample,
+                          .slot = slot,
+                          .index = 0,
+                          .frac = 0.0f,
+                          .rate = pitch * sample->sample_rate / sampleRate,
+                          .gain = gain,
+                          .age = ++trigger_count,
+                          .active = true};
+}
+
+void sampler_render(float *out, int frames) {
+  for (int v = 0; v < SAMPLER_MAX_VOICES; v++) {
+    SamplerVoice *voice = &voices[v];
+    if (!voice->active)
+      continue;
+
+    const Sample *sample = voice->sample;
+    uint32_t end = sample->looped ? sample->loop_end : sample->frame_count - 1;
+    uint32_t index = voice->index;
+    float frac = voice->frac;
+
+    for (int i = 0; i < frames; i++) {
+      // Linear interpolation between neighbouring frames
+      uint32_t next = index + 1;
+      if (sample->looped && next >= sample->loop_end)
+        next = sample->loop_start;
+      float a = sample_read_frame(sample, index);
+      float b = sample_read_frame(sample, next);
+      out[i] += (a + (b - a) * frac) * voice->gain;
+
+      frac += voice->rate;
+      uint32_t step = (uint32_t)frac;
+      index += step;
+      frac -= step;
+
+      if (index >= end) {
+        if (!sample->looped) {
+          voice->active = false;
+          break;
+        }
+        index = sample->loop_start +
+                (index - sample->loop_start) %
+                    (sample->loop_end - sample->loop_start);
+      }
+    }
+
+    voice->index = index;
+    voice->frac = frac;
+  }
+}
+
+// Only call once the audio device is stopped
+void sampler_shutdown() {
+  for (int v = 0; v < SAMPLER_MAX_VOICES; v++) {
+    voices[v].active = false;
+  }
+  for (int slot = 0; slot < SAMPLER_MAX_SLOTS; slot++) {
+    sample_close(&slots[slot]);
+  }
+  slot_count = 0;
+}
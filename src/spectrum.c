@@ -0,0 +1,224 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L // clock_gettime, nanosleep
+#endif
+
+#include "spectrum.h"
+#include "denormal.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#ifndef __EMSCRIPTEN__
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define SPECTRUM_HALF (SPECTRUM_FFT_SIZE / 2)
+#define SPECTRUM_FRESH 4 // Set on the shared index when a new frame is ready
+
+// Lock-free tap written by the audio thread
+static float tap[SPECTRUM_TAP_SIZE];
+static atomic_uint tap_written = 0;
+
+// Analysis tables, built once in spectrum_init
+static float window[SPECTRUM_FFT_SIZE];
+static float twiddle_re[SPECTRUM_HALF / 2];
+static float twiddle_im[SPECTRUM_HALF / 2];
+static float split_re[SPECTRUM_HALF];
+static float split_im[SPECTRUM_HALF];
+static int bit_reverse[SPECTRUM_HALF];
+static int band_lo[SPECTRUM_BINS];
+static int band_hi[SPECTRUM_BINS];
+static float magnitude_scale;
+
+// Worker-side scratch
+static float frame_input[SPECTRUM_FFT_SIZE];
+static float fft_re[SPECTRUM_HALF];
+static float fft_im[SPECTRUM_HALF];
+static float magnitudes[SPECTRUM_HALF + 1];
+static float held_levels[SPECTRUM_BINS];
+static float held_peaks[SPECTRUM_BINS];
+
+// Triple buffer: the worker fills back, the render thread reads front
+static SpectrumFrame frames[3];
+static atomic_int shared_frame = 1;
+static int back_frame = 0;
+static int front_frame = 2;
+
+#ifndef __EMSCRIPTEN__
+static pthread_t worker;
+static atomic_bool worker_running = false;
+#endif
+
+void spectrum_tap(const float *samples, int frames) {
+  unsigned int written = atomic_load_explicit(&tap_written,
+                                              memory_order_relaxed);
+  unsigned int start = written & (SPECTRUM_TAP_SIZE - 1);
+  unsigned int first = SPECTRUM_TAP_SIZE - start;
+  if (first > (unsigned int)frames)
+    first = frames;
+  memcpy(tap + start, samples, first * sizeof(float));
+  memcpy(tap, samples + first, (frames - first) * sizeof(float));
+  atomic_store_explicit(&tap_written, written + frames, memory_order_release);
+}
+
+static void build_tables() {
+  for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+    window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / SPECTRUM_FFT_SIZE);
+  }
+  // Hann has a coherent gain of 0.5, so a full-scale sine reads 0 dB
+  magnitude_scale = 4.0f / SPECTRUM_FFT_SIZE;
+
+  for (int i = 0; i < SPECTRUM_HALF / 2; i++) {
+    twiddle_re[i] = cosf(2.0f * PI * i / SPECTRUM_HALF);
+    twiddle_im[i] = -sinf(2.0f * PI * i / SPECTRUM_HALF);
+  }
+  for (int k = 0; k < SPECTRUM_HALF; k++) {
+    split_re[k] = cosf(2.0f * PI * k / SPECTRUM_FFT_SIZE);
+    split_im[k] = -sinf(2.0f * PI * k / SPECTRUM_FFT_SIZE);
+  }
+
+  int bits = 0;
+  while ((1 << bits) < SPECTRUM_HALF)
+    bits++;
+  for (int i = 0; i < SPECTRUM_HALF; i++) {
+    int reversed = 0;
+    for (int b = 0; b < bits; b++) {
+      if (i & (1 << b))
+        reversed |= 1 << (bits - 1 - b);
+    }
+    bit_reverse[i] = reversed;
+  }
+
+  // Log-spaced bands; narrow low bands collapse onto their nearest bin
+  float bin_hz = sampleRate / SPECTRUM_FFT_SIZE;
+  float ratio = SPECTRUM_MAX_FREQ / SPECTRUM_MIN_FREQ;
+  for (int b = 0; b < SPECTRUM_BINS; b++) {
+    float lo = SPECTRUM_MIN_FREQ * powf(ratio, (float)b / SPECTRUM_BINS);
+    float hi = SPECTRUM_MIN_FREQ * powf(ratio, (float)(b + 1) / SPECTRUM_BINS);
+    band_lo[b] = (int)(lo / bin_hz + 0.5f);
+    band_hi[b] = (int)(hi / bin_hz + 0.5f);
+    if (band_lo[b] > SPECTRUM_HALF)
+      band_lo[b] = SPECTRUM_HALF;
+    if (band_hi[b] > SPECTRUM_HALF + 1)
+      band_hi[b] = SPECTRUM_HALF + 1;
+    if (band_hi[b] <= band_lo[b])
+      band_hi[b] = band_lo[b] + 1;
+  }
+}
+
+// Real FFT of frame_input: an N/2 complex FFT on the even/odd samples,
+// then a split pass to recover the N/2 + 1 real-input bins
+static void real_fft() {
+  for (int k = 0; k < SPECTRUM_HALF; k++) {
+    int r = bit_reverse[k];
+    fft_re[r] = frame_input[2 * k] * window[2 * k];
+    fft_im[r] = frame_input[2 * k + 1] * window[2 * k + 1];
+  }
+
+  for (int size = 2; size <= SPECTRUM_HALF; size *= 2) {
+    int half = size / 2;
+    int stride = SPECTRUM_HALF / size;
+    for (int start = 0; start < SPECTRUM_HALF; start += size) {
+      for (int j = 0; j < half; j++) {
+        float wr = twiddle_re[j * stride];
+        float wi = twiddle_im[j * stride];
+        int a = start + j;
+        int b = a + half;
+        float tr = fft_re[b] * wr - fft_im[b] * wi;
+        float ti = fft_re[b] * wi + fft_im[b] * wr;
+        fft_re[b] = fft_re[a] - tr;
+        fft_im[b] = fft_im[a] - ti;
+        fft_re[a] += tr;
+        fft_im[a] += ti;
+      }
+    }
+  }
+
+  magnitudes[0] = fabsf(fft_re[0] + fft_im[0]);
+  magnitudes[SPECTRUM_HALF] = fabsf(fft_re[0] - fft_im[0]);
+  for (int k = 1; k < SPECTRUM_HALF; k++) {
+    float zr = fft_re[k], zi = fft_im[k];
+    float cr = fft_re[SPECTRUM_HALF - k], ci = -fft_im[SPECTRUM_HALF - k];
+    float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+    float dr = 0.5f * (zr - cr), di = 0.5f * (zi - ci);
+    // X[k] = E + W^k * (-i) * D
+    float or_ = di, oi = -dr;
+    float xr = er + split_re[k] * or_ - split_im[k] * oi;
+    float xi = ei + split_re[k] * oi + split_im[k] * or_;
+    magnitudes[k] = sqrtf(xr * xr + xi * xi);
+  }
+}
+
+static void analyze(float dt) {
+  unsigned int written = atomic_load_explicit(&tap_written,
+                                              memory_order_acquire);
+  unsigned int start = written - SPECTRUM_FFT_SIZE;
+  for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+    frame_input[i] = tap[(start + i) & (SPECTRUM_TAP_SIZE - 1)];
+  }
+  real_fft();
+
+  SpectrumFrame *frame = &frames[back_frame];
+  for (int b = 0; b < SPECTRUM_BINS; b++) {
+    float peak = 0.0f;
+    for (int k = band_lo[b]; k < band_hi[b]; k++) {
+      peak = fmaxf(peak, magnitudes[k]);
+    }
+    float db = 20.0f * log10f(peak * magnitude_scale + 1e-9f);
+    float level = fminf(fmaxf(1.0f - db / SPECTRUM_FLOOR_DB, 0.0f), 1.0f);
+
+    held_levels[b] = fmaxf(level, held_levels[b] * SPECTRUM_RELEASE);
+    held_peaks[b] =
+        fmaxf(held_levels[b], held_peaks[b] - SPECTRUM_PEAK_FALL * dt);
+  }
+  memcpy(frame->levels, held_levels, sizeof(held_levels));
+  memcpy(frame->peaks, held_peaks, sizeof(held_peaks));
+
+  back_frame = atomic_exchange(&shared_frame, back_frame | SPECTRUM_FRESH) &
+               ~SPECTRUM_FRESH;
+}
+
+#ifndef __EMSCRIPTEN__
+static void *spectrum_worker(void *arg) {
+  (void)arg;
+  denormals_disable();
+  struct timespec period = {0, 1000000000L / SPECTRUM_RATE};
+  while (atomic_load(&worker_running)) {
+    analyze(1.0f / SPECTRUM_RATE);
+    nanosleep(&period, NULL);
+  }
+  return NULL;
+}
+#endif
+
+void spectrum_init() {
+  build_tables();
+#ifndef __EMSCRIPTEN__
+  atomic_store(&worker_running, true);
+  if (pthread_create(&worker, NULL, spectrum_worker, NULL) != 0)
+    atomic_store(&worker_running, false);
+#endif
+}
+
+void spectrum_shutdown() {
+#ifndef __EMSCRIPTEN__
+  if (atomic_exchange(&worker_running, false))
+    pthread_join(worker, NULL);
+#endif
+}
+
+// Without threads the analysis runs on the render thread, once per frame;
+// dt is the frame time, since the library has no clock of its own
+void spectrum_update(float dt) {
+#ifdef __EMSCRIPTEN__
+  analyze(dt);
+#else
+  (void)dt;
+#endif
+}
+
+const SpectrumFrame *spectrum_latest() {
+  if (atomic_load(&shared_frame) & SPECTRUM_FRESH)
+    front_frame = atomic_exchange(&shared_frame, front_frame) & ~SPECTRUM_FRESH;
+  return &frames[front_frame];
+}
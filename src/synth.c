@@ -1,9 +1,19 @@
 #include "synth.h"
-#include "rope.h"
-#include "utils.h"
-
-typedef void (*SynthCallback)(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                              float *modPhase);
+#include "denormal.h"
+#include "governor.h"
+#include "granular.h"
+#include "kernels.h"
+#include "limiter.h"
+#include "recorder.h"
+#include "sampler.h"
+#include "spectrum.h"
+#include "unison.h"
+#include "vocoder.h"
+#include "waveguide.h"
+#include <stdatomic.h>
+#include <string.h>
+
+typedef void (*SynthCallback)(FMSynth *fmSynth, VoiceBlock *block);
 
 FMSynth Instruments[MAX_INSTRUMENTS] = {
     {.carrierFreq = 440.0f,
@@ -13,7 +23,10 @@ FMSynth Instruments[MAX_INSTRUMENTS] = {
      .sequence = pentatonicSequence,
      .currentNote = 0,
      .resonance = 2.0f,
-     .volume = 0.0f},
+     .volume = 0.0f,
+     .unison = 1,
+     .detune = 25.0f,
+     .stereoSpread = 0.8f},
     {.carrierFreq = 660.0f,
      .carrierShape = SQUARE,
      .modulatorFreq = 440.0f,
@@ -21,7 +34,9 @@ FMSynth Instruments[MAX_INSTRUMENTS] = {
      .sequence = bassSequence,
      .currentNote = 0,
      .resonance = 2.0f,
-     .volume = 0.0f},
+     .volume = 0.0f,
+     .envControls = {0.1f, 0.9f, 0.0f, 0.2f, 0.5f},
+     .unison = 1},
     {.carrierFreq = 60.0f,
      .carrierShape = TRIANGLE,
      .modulatorFreq = 440.0f,
@@ -29,7 +44,9 @@ FMSynth Instruments[MAX_INSTRUMENTS] = {
      .sequence = arpeggioSequence,
      .currentNote = 0,
      .resonance = 2.0f,
-     .volume = 0.0f},
+     .volume = 0.0f,
+     .envControls = {0.006f, 0.05f, 0.5f, 0.08f, 0.1f},
+     .unison = 1},
     {.carrierFreq = 220.0f,
      .carrierShape = SINE,
      .modulatorFreq = 440.0f,
@@ -37,17 +54,62 @@ FMSynth Instruments[MAX_INSTRUMENTS] = {
      .sequence = constSequence,
      .currentNote = 0,
      .resonance = 2.0f,
-     .volume = 0.0f},
+     .volume = 0.0f,
+     .unison = 1},
 };
 
 // Initialize static variables
 static float modPhases[MAX_INSTRUMENTS] = {0.0f};
 static ResonantFilter filter_states[MAX_INSTRUMENTS] = {0};
+static ResonantFilter filter_states_right[MAX_INSTRUMENTS] = {0};
+static UnisonState unison_states[MAX_INSTRUMENTS] = {0};
+static bool dormant[MAX_INSTRUMENTS] = {0};
+static int filter_modes[MAX_INSTRUMENTS] = {0}; // Mode each state was run with
+static float last_outputs[MAX_INSTRUMENTS][2];  // Final L/R sample per voice
+static Limiter master_limiter = {0};
 static float sub_beat_timer = 0.0f;
 static int arp_direction = UP;
-
-static EnvControls rhythm_env = {0.1f, 0.9f, 0.0f, 0.0f, 0.0f};
-static EnvControls arpeggio_env = {0.05f, 0.4f, 0.0f, 0.0f, 0.0f};
+static uint32_t random_state = 0x9E3779B9u;
+
+static Envelope envelopes[MAX_INSTRUMENTS] = {0};
+static uint32_t gate_frames[MAX_INSTRUMENTS] = {0}; // Until release, 0 holds
+static float envelope_buffers[MAX_INSTRUMENTS][AUDIO_BLOCK_SIZE];
+static float sampler_buffer[AUDIO_BLOCK_SIZE];
+static float string_buffer[AUDIO_BLOCK_SIZE];
+static float voice_buffer[AUDIO_BLOCK_SIZE];
+static float voice_buffer_right[AUDIO_BLOCK_SIZE];
+static float master_buffer[AUDIO_BLOCK_SIZE];
+static float master_buffer_right[AUDIO_BLOCK_SIZE];
+static float carrier_buffer[AUDIO_BLOCK_SIZE];
+static float grain_buffer[AUDIO_BLOCK_SIZE];
+static float grain_buffer_right[AUDIO_BLOCK_SIZE];
+
+// Preset handoff from the render thread. The audio thread takes the pointer,
+// copies what it needs and bumps the epoch once the callback is done with it.
+static _Atomic(const SynthPreset *) pending_preset = NULL;
+static atomic_uint audio_epoch = 0;
+static int preset_sequences[MAX_INSTRUMENTS][SEQ_SIZE];
+
+// Rope-derived controls, triple buffered: the app publishes into the shared
+// slot and the audio thread swaps it for its own when a fresh one is there
+#define CONTROLS_FRESH 4
+static SynthControls control_slots[3];
+static atomic_int shared_controls = 1;
+static int back_controls = 0;  // Owned by the app
+static int front_controls = 2; // Owned by the audio thread
+static SynthControls controls; // What the current callback renders with
+
+// Beat flags raised by the app and consumed once per callback
+static atomic_bool beat_pending = false;
+static atomic_bool sub_beat_pending = false;
+
+// xorshift, so the sequencer doesn't need the windowing library's RNG
+static int random_range(int min, int max) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return min + (int)(random_state % (uint32_t)(max - min + 1));
+}
 
 float generate_shape(int shape, float t) {
   switch (shape) {
@@ -65,19 +127,19 @@ float generate_shape(int shape, float t) {
 }
 
 float calculate_alpha_cutoff(float cut_off) {
-  float dt = 1.0f / SAMPLE_RATE;
+  float dt = 1.0f / sampleRate;
   float RC = 1.0f / (2.0f * PI * cut_off);
   return dt / (RC + dt);
 }
 
-void resonant_lowpass_callback(float *sample, ResonantFilter *filter,
-                               float cutoff, float resonance) {
+void resonant_lowpass_coeffs(BiquadCoeffs *coeffs, float cutoff,
+                             float resonance) {
   // Constrain parameters to stable ranges
-  cutoff = fminf(fmaxf(cutoff, 20.0f), SAMPLE_RATE / 2.0f);
+  cutoff = fminf(fmaxf(cutoff, 20.0f), sampleRate / 2.0f);
   resonance = fmaxf(resonance, 0.0f); // Resonance >= 0
 
   // Calculate filter coefficients
-  float w0 = 2.0f * PI * cutoff / SAMPLE_RATE;
+  float w0 = 2.0f * PI * cutoff / sampleRate;
   float alpha = sinf(w0) / (2.0f * (1.0f + resonance));
   float cosw0 = cosf(w0);
 
@@ -89,54 +151,23 @@ void resonant_lowpass_callback(float *sample, ResonantFilter *filter,
   float b2 = (1.0f - cosw0) / 2.0f;
 
   // Normalize coefficients
-  a1 /= a0;
-  a2 /= a0;
-  b0 /= a0;
-  b1 /= a0;
-  b2 /= a0;
-
-  // Process sample
-  float x = *sample;
-  float y = b0 * x + b1 * filter->prev_x + b2 * filter->prev_x -
-            a1 * filter->prev_y1 - a2 * filter->prev_y2;
-
-  // Update filter state
-  filter->prev_x = x;
-  filter->prev_y2 = filter->prev_y1;
-  filter->prev_y1 = y;
-
-  *sample = y;
+  coeffs->a1 = a1 / a0;
+  coeffs->a2 = a2 / a0;
+  coeffs->b0 = b0 / a0;
+  coeffs->b1 = b1 / a0;
+  coeffs->b2 = b2 / a0;
 }
 
-void rope_lowpass_callback(float *sample, ResonantFilter *filter,
-                           float rope_length, float resonance) {
-  float cut_off = lerp1D(MIN_CUTOFF_FREQUENCY, MAX_CUTOFF_FREQUENCY,
-                         rope_length / MAX_ROPE_LENGTH);
-  float alpha = calculate_alpha_cutoff(cut_off);
-  resonant_lowpass_callback(sample, filter, cut_off, resonance);
-}
-
-void envelope_callback(float *sample, EnvControls *envControls) {
-  float attack = envControls->attack;
-  float decay = envControls->decay;
-  float sustain = envControls->sustain;
-  float release = envControls->release;
-  float phase = envControls->phase;
-  if (phase < attack) {
-    *sample *= phase / attack;
-  } else if (phase < attack + decay) {
-    *sample *= lerp1D(1.0f, sustain, (phase - attack) / decay);
-  } else if (phase < 1.0f - release) {
-    *sample *= sustain;
-  } else {
-    *sample *= lerp1D(sustain, 0.0f, (phase - (1.0f - release)) / release);
-  }
+void rope_lowpass_coeffs(BiquadCoeffs *coeffs, float stretch,
+                         float resonance) {
+  float cut_off = lerp1D(MIN_CUTOFF_FREQUENCY, MAX_CUTOFF_FREQUENCY, stretch);
+  resonant_lowpass_coeffs(coeffs, cut_off, resonance);
 }
 
 void delay_callback(float *sample, float *buffer, float *delay_time,
                     float *feedback, float *wet) {
   // Calculate delay time in samples
-  float delay_samples = *delay_time * SAMPLE_RATE;
+  float delay_samples = *delay_time * sampleRate;
   int delay_samples_int = (int)delay_samples;
   float frac = delay_samples - delay_samples_int;
 
@@ -153,197 +184,426 @@ void delay_callback(float *sample, float *buffer, float *delay_time,
             *sample * (1.0f - *wet);
 }
 
-// Common FM synthesis processing function
-void process_fm_synthesis(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                          float *modPhase) {
-  float modSignal = sinf(2.0f * PI * (*modPhase)) * fmSynth->modIndex;
-  float fmFrequency = fmSynth->carrierFreq + (modSignal * fmSynth->carrierFreq);
+// Pick the rope filter for a block according to the current quality tier
+static void rope_filter_block(VoiceBlock *block, float stretch,
+                              float resonance) {
+  int tier = governor_tier();
+  if (tier >= QUALITY_BYPASS) {
+    block->filterMode = FILTER_NONE;
+  } else if (tier >= QUALITY_CHEAP_FILTER) {
+    float cut_off =
+        lerp1D(MIN_CUTOFF_FREQUENCY, MAX_CUTOFF_FREQUENCY, stretch);
+    block->filterMode = FILTER_ONE_POLE;
+    block->filter.b0 = calculate_alpha_cutoff(cut_off);
+  } else {
+    block->filterMode = FILTER_BIQUAD;
+    rope_lowpass_coeffs(&block->filter, stretch, resonance);
+  }
+}
 
-  // Generate waveform
-  float synthSample = generate_shape(fmSynth->carrierShape, fmSynth->phase);
-  synthSample *= fmSynth->volume;
+// One-pole and biquad share ResonantFilter, so a tier change would run the
+// new filter on the other one's history and click. Both are unity gain at
+// DC, so filling every tap with the voice's last output sample carries the
+// level across with no step. That sample is the unfiltered one when the
+// voice comes out of a bypass.
+static void switch_filter_mode(int index, int mode) {
+  ResonantFilter *states[] = {&filter_states[index],
+                              &filter_states_right[index]};
+  for (int c = 0; c < 2; c++) {
+    float y = last_outputs[index][c];
+    *states[c] = (ResonantFilter){y, y, y, y};
+  }
+  filter_modes[index] = mode;
+}
 
-  // Update phase accumulators
-  fmSynth->phase += fmFrequency / SAMPLE_RATE;
-  if (fmSynth->phase >= 1.0f)
-    fmSynth->phase -= 1.0f;
+// Instrument callbacks run once per block: they update the voice from the
+// rope and sequencer and pick which render stages the block needs.
+void lead_synth_callback(FMSynth *fmSynth, VoiceBlock *block) {
+  if (!fmSynth || !block)
+    return;
 
-  *modPhase += fmSynth->modulatorFreq / SAMPLE_RATE;
-  if (*modPhase >= 1.0f)
-    *modPhase -= 1.0f;
+  fmSynth->carrierFreq = controls.leadFreq;
 
-  // Store in buffer and add to output
-  fmSynth->buffer[frame % BUFFER_SIZE] = synthSample;
-  *sample += synthSample;
+  // Apply rope-based filtering
+  rope_filter_block(block, controls.stretch, fmSynth->resonance);
+
+  // Update modulator frequency based on rope length
+  fmSynth->modulatorFreq = lerp1D(0, 6, controls.stretch);
 }
 
-void lead_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                         float *modPhase) {
-  if (!sample || !fmSynth || !modPhase)
+void rhythm_synth_callback(FMSynth *fmSynth, VoiceBlock *block) {
+  if (!fmSynth || !block)
     return;
 
-  fmSynth->carrierFreq = freq_from_rope_dir(&rope);
-  float synthSample = 0.0f;
-  process_fm_synthesis(&synthSample, frame, fmSynth, modPhase);
+  // Sampler hits carry their own shape, so only FM notes use the envelope
+  if (fmSynth->voiceType != VOICE_SAMPLER) {
+    fmSynth->carrierFreq =
+        midi_to_freq(fmSynth->sequence[fmSynth->currentNote % 8]);
+    block->useEnvelope = true;
+  }
 
-  float rope_length = Vector2Distance(rope.end, rope.start);
-  float max_rope_length = 400;
+  rope_filter_block(block, controls.stretch, fmSynth->resonance);
+}
 
-  // Apply rope-based filtering
-  rope_lowpass_callback(&synthSample, &filter_states[0], rope_length,
-                        fmSynth->resonance);
+void arpeggio_synth_callback(FMSynth *fmSynth, VoiceBlock *block) {
+  if (!fmSynth || !block)
+    return;
 
-  // Update modulator frequency based on rope length
-  fmSynth->modulatorFreq = lerp1D(0, 6, rope_length / max_rope_length);
+  fmSynth->carrierFreq = midi_to_freq(fmSynth->sequence[fmSynth->currentNote]);
+
+  // Apply envelope and filtering
+  block->useEnvelope = true;
 
-  *sample += synthSample; // Add the processed sample to the output
+  rope_filter_block(block, controls.stretch, fmSynth->resonance);
 }
 
-void rhythm_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                           float *modPhase) {
-  if (!sample || !fmSynth || !modPhase)
+void const_synth_callback(FMSynth *fmSynth, VoiceBlock *block) {
+  if (!fmSynth || !block)
     return;
 
-  if (globalControls.beat_triggered) {
-    fmSynth->currentNote = GetRandomValue(0, 7);
-  }
-
   fmSynth->carrierFreq =
       midi_to_freq(fmSynth->sequence[fmSynth->currentNote % 8]);
+}
 
-  float synthSample = 0.0f;
-  process_fm_synthesis(&synthSample, frame, fmSynth, modPhase);
+// Rope angle picks where grains read from, its length trades grain size
+// for density and the speed of its end bends the pitch up
+static void granular_controls_from_rope(GranularControls *grains) {
+  float stretch = fminf(controls.stretch, 1.0f);
+  grains->position = controls.direction;
+  grains->density = lerp1D(GRANULAR_MIN_DENSITY, GRANULAR_MAX_DENSITY, stretch);
+  grains->size = lerp1D(GRANULAR_MAX_SIZE, GRANULAR_MIN_SIZE, stretch);
+  grains->pitch = lerp1D(1.0f, GRANULAR_MAX_PITCH, controls.motion);
+}
 
-  // Apply envelope and filtering
-  float beat_duration = 60.0f / globalControls.bpm;
-  rhythm_env.phase =
-      fmodf(globalControls.beat_time, beat_duration) / beat_duration;
+// Render one instrument's block with the kernel specialised for its setup.
+// The dispatch happens here, once per block, never per sample. Unison voices
+// come out in stereo into out/out_right; everything else is mono in out and
+// the return value says which.
+static bool render_voice(int index, const VoiceBlock *block, int unison,
+                         float *out, float *out_right, int frames) {
+  FMSynth *fmSynth = &Instruments[index];
+  if (fmSynth->voiceType == VOICE_SAMPLER) {
+    for (int i = 0; i < frames; i++) {
+      out[i] = sampler_buffer[i] * fmSynth->volume;
+    }
+    filter_process(&filter_states[index], block->filterMode, &block->filter,
+                   out, frames);
+    return false;
+  }
 
-  envelope_callback(&synthSample, &rhythm_env);
+  if (unison > 1) {
+    // The stack replaces the FM carrier, so the modulator is not applied
+    unison_render(&unison_states[index], fmSynth->carrierShape, unison,
+                  fmSynth->carrierFreq, fmSynth->detune, fmSynth->stereoSpread,
+                  fmSynth->volume,
+                  block->useEnvelope ? envelope_buffers[index] : NULL, out,
+                  out_right, frames);
+    filter_process(&filter_states[index], block->filterMode, &block->filter,
+                   out, frames);
+    filter_process(&filter_states_right[index], block->filterMode,
+                   &block->filter, out_right, frames);
+    return true;
+  }
 
-  float rope_length = Vector2Distance(rope.end, rope.start);
-  rope_lowpass_callback(&synthSample, &filter_states[1], rope_length,
-                        fmSynth->resonance);
+  RenderKernel kernel =
+      select_render_kernel(fmSynth->carrierShape, fmSynth->modIndex != 0.0f,
+                           block->filterMode, block->useEnvelope);
+  kernel(fmSynth, &modPhases[index], &filter_states[index], &block->filter,
+         envelope_buffers[index], out, frames);
+  return false;
+}
 
-  *sample += synthSample; // Add the processed sample to the output
+// A voice that is muted, or whose note has ended, produces nothing new
+static bool voice_gated_off(int index, const VoiceBlock *block) {
+  return Instruments[index].volume == 0.0f ||
+         (block->useEnvelope && envelopes[index].stage == ENV_IDLE);
 }
 
-void arpeggio_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                             float *modPhase) {
-  if (!sample || !fmSynth || !modPhase)
-    return;
+static bool block_is_silent(const float *left, const float *right,
+                            int frames) {
+  for (int i = 0; i < frames; i++) {
+    if (fabsf(left[i]) > VOICE_SILENCE || fabsf(right[i]) > VOICE_SILENCE)
+      return false;
+  }
+  return true;
+}
 
-  if (globalControls.sub_beat_triggered) {
-    switch (globalControls.arp_mode) {
-    case UP:
+static void advance_arpeggio(FMSynth *fmSynth) {
+  switch (controls.arpMode) {
+  case UP:
+    fmSynth->currentNote++;
+    if (fmSynth->currentNote >= SUB_BEATS)
+      fmSynth->currentNote = 0;
+    break;
+  case DOWN:
+    fmSynth->currentNote--;
+    if (fmSynth->currentNote < 0)
+      fmSynth->currentNote = SUB_BEATS - 1;
+    break;
+  case UP_DOWN:
+    if (fmSynth->currentNote == 0) {
+      arp_direction = UP;
+    } else if (fmSynth->currentNote == SUB_BEATS - 1) {
+      arp_direction = DOWN;
+    }
+    if (arp_direction == UP) {
       fmSynth->currentNote++;
-      if (fmSynth->currentNote >= SUB_BEATS)
-        fmSynth->currentNote = 0;
-      break;
-    case DOWN:
+    } else {
       fmSynth->currentNote--;
-      if (fmSynth->currentNote < 0)
-        fmSynth->currentNote = SUB_BEATS - 1;
-      break;
-    case UP_DOWN:
-      if (fmSynth->currentNote == 0) {
-        arp_direction = UP;
-      } else if (fmSynth->currentNote == SUB_BEATS - 1) {
-        arp_direction = DOWN;
-      }
-      if (arp_direction == UP) {
-        fmSynth->currentNote++;
-      } else {
-        fmSynth->currentNote--;
-      }
-      break;
-    case DOWN_UP:
-      if (fmSynth->currentNote == 0) {
-        arp_direction = DOWN;
-      } else if (fmSynth->currentNote == SUB_BEATS - 1) {
-        arp_direction = UP;
-      }
-      if (arp_direction == UP) {
-        fmSynth->currentNote++;
-      } else {
-        fmSynth->currentNote--;
-      }
-      break;
-    case RANDOM:
-      fmSynth->currentNote = GetRandomValue(0, SUB_BEATS - 1);
-      break;
-    };
+    }
+    break;
+  case DOWN_UP:
+    if (fmSynth->currentNote == 0) {
+      arp_direction = DOWN;
+    } else if (fmSynth->currentNote == SUB_BEATS - 1) {
+      arp_direction = UP;
+    }
+    if (arp_direction == UP) {
+      fmSynth->currentNote++;
+    } else {
+      fmSynth->currentNote--;
+    }
+    break;
+  case RANDOM:
+    fmSynth->currentNote = random_range(0, SUB_BEATS - 1);
+    break;
   }
+}
 
-  fmSynth->carrierFreq = midi_to_freq(fmSynth->sequence[fmSynth->currentNote]);
+static void note_on(int index) {
+  const EnvControls *envControls = &Instruments[index].envControls;
+  envelope_gate_on(&envelopes[index], envControls);
+  gate_frames[index] = (uint32_t)(envControls->gate * sampleRate);
+}
 
-  float synthSample = 0.0f;
-  process_fm_synthesis(&synthSample, frame, fmSynth, modPhase);
+// Render a block of envelope, releasing the note on the exact frame its gate
+// time runs out
+static void render_envelope(int index, uint32_t frames) {
+  Envelope *env = &envelopes[index];
+  float *out = envelope_buffers[index];
+  uint32_t remaining = gate_frames[index];
+  if (remaining == 0 || remaining > frames) {
+    envelope_render(env, out, frames);
+    if (remaining > 0)
+      gate_frames[index] = remaining - frames;
+    return;
+  }
+  envelope_render(env, out, remaining);
+  envelope_gate_off(env, &Instruments[index].envControls);
+  envelope_render(env, out + remaining, frames - remaining);
+  gate_frames[index] = 0;
+}
 
-  // Apply envelope and filtering
-  float beat_duration = 60.0f / (globalControls.bpm * SUB_BEATS);
-  arpeggio_env.phase =
-      fmodf(globalControls.sub_beat_time, beat_duration) / beat_duration;
-  envelope_callback(&synthSample, &arpeggio_env);
+// Start new notes on beat events. Runs once per device period, before any
+// samples are rendered, so every voice sees its gate on the same frame.
+static void sequencer_step(bool beat_triggered, bool sub_beat_triggered) {
+  if (beat_triggered) {
+    FMSynth *rhythm = &Instruments[1];
+    rhythm->currentNote = random_range(0, 7);
+    if (rhythm->voiceType == VOICE_SAMPLER) {
+      int note = rhythm->sequence[rhythm->currentNote % 8];
+      float pitch = midi_to_freq(note) / midi_to_freq(SAMPLER_ROOT_NOTE);
+      sampler_trigger(rhythm->currentNote % sampler_slot_count(), pitch, 1.0f);
+    }
+    note_on(1);
+    Instruments[3].currentNote = random_range(0, 7);
+  }
+  if (sub_beat_triggered) {
+    advance_arpeggio(&Instruments[2]);
+    note_on(2);
+  }
+}
+
+bool synth_is_silent() {
+  for (int j = 0; j < MAX_INSTRUMENTS; j++) {
+    if (Instruments[j].volume != 0.0f)
+      return false;
+  }
+  return true;
+}
+
+void synth_queue_preset(const SynthPreset *preset) {
+  atomic_store(&pending_preset, preset);
+}
 
-  float rope_length = Vector2Distance(rope.end, rope.start);
-  rope_lowpass_callback(&synthSample, &filter_states[1], rope_length,
-                        fmSynth->resonance);
+uint32_t synth_audio_epoch() { return atomic_load(&audio_epoch); }
 
-  *sample += synthSample; // Add the processed sample to the output
+void synth_set_controls(const SynthControls *newControls) {
+  control_slots[back_controls] = *newControls;
+  back_controls =
+      atomic_exchange(&shared_controls, back_controls | CONTROLS_FRESH) &
+      ~CONTROLS_FRESH;
 }
 
-void const_synth_callback(float *sample, ma_uint32 frame, FMSynth *fmSynth,
-                          float *modPhase) {
-  if (!sample || !fmSynth || !modPhase)
+static void acquire_controls() {
+  if (!(atomic_load(&shared_controls) & CONTROLS_FRESH))
     return;
+  front_controls =
+      atomic_exchange(&shared_controls, front_controls) & ~CONTROLS_FRESH;
+  controls = control_slots[front_controls];
+}
 
-  if (globalControls.beat_triggered) {
-    fmSynth->currentNote = GetRandomValue(0, 7);
+void synth_trigger_beat() { atomic_store(&beat_pending, true); }
+
+void synth_trigger_sub_beat() { atomic_store(&sub_beat_pending, true); }
+
+static void apply_preset(const SynthPreset *preset) {
+  for (int j = 0; j < MAX_INSTRUMENTS; j++) {
+    const InstrumentPreset *instrument = &preset->instruments[j];
+    FMSynth *fmSynth = &Instruments[j];
+    fmSynth->carrierFreq = instrument->carrierFreq;
+    fmSynth->carrierShape = instrument->carrierShape;
+    fmSynth->modulatorFreq = instrument->modulatorFreq;
+    fmSynth->modIndex = instrument->modIndex;
+    fmSynth->resonance = instrument->resonance;
+    fmSynth->volume = instrument->volume;
+    fmSynth->envControls = instrument->envControls;
+    fmSynth->unison = instrument->unison;
+    fmSynth->detune = instrument->detune;
+    fmSynth->stereoSpread = instrument->stereoSpread;
+    for (int i = 0; i < SEQ_SIZE; i++) {
+      preset_sequences[j][i] = instrument->sequence[i];
+    }
+    fmSynth->sequence = preset_sequences[j];
   }
-
-  fmSynth->carrierFreq =
-      midi_to_freq(fmSynth->sequence[fmSynth->currentNote % 8]);
-  float synthSample = 0.0f;
-  process_fm_synthesis(&synthSample, frame, fmSynth, modPhase);
-  *sample += synthSample; // Add the processed sample to the output
 }
 
-void audio_callback(ma_device *device, void *output, const void *input,
-                    ma_uint32 frameCount) {
-  if (!device || !output)
+// Render interleaved stereo. input is mono capture for the vocoder, or NULL.
+void synth_render(float *out, const float *input, uint32_t frameCount) {
+  if (!out)
     return;
 
-  float *out = (float *)output;
+  denormals_disable();
   static const SynthCallback callbacks[MAX_INSTRUMENTS] = {
       lead_synth_callback, rhythm_synth_callback, arpeggio_synth_callback,
       const_synth_callback};
 
-  // Process one frame at a time
-  for (ma_uint32 i = 0; i < frameCount; i++) {
-    float sample = 0.0f;
-    bool beat_triggered =
-        globalControls.beat_triggered; // Store the current beat state
-    bool sub_beat_triggered =
-        globalControls.sub_beat_triggered; // Store the current sub-beat state
+  double start_time = governor_now();
+  int tier = governor_tier();
+  sampler_set_voice_limit(tier >= QUALITY_FEWER_VOICES ? SAMPLER_REDUCED_VOICES
+                                                       : SAMPLER_MAX_VOICES);
+  int unison_limit = tier >= QUALITY_FEWER_VOICES ? UNISON_REDUCED_VOICES
+                                                  : UNISON_MAX_VOICES;
+  waveguide_set_string_limit(tier >= QUALITY_FEWER_VOICES
+                                 ? WAVEGUIDE_REDUCED_STRINGS
+                                 : WAVEGUIDE_MAX_STRINGS);
+  granular_set_grain_limit(tier >= QUALITY_FEWER_VOICES
+                               ? GRANULAR_REDUCED_GRAINS
+                               : GRANULAR_MAX_GRAINS);
+
+  const SynthPreset *preset = atomic_exchange(&pending_preset, NULL);
+  if (preset)
+    apply_preset(preset);
+
+  acquire_controls();
+
+  // Consume the beat flags set by the app
+  bool beat_triggered = atomic_exchange(&beat_pending, false);
+  bool sub_beat_triggered = atomic_exchange(&sub_beat_pending, false);
+  sequencer_step(beat_triggered, sub_beat_triggered);
+
+  for (uint32_t offset = 0; offset < frameCount; offset += AUDIO_BLOCK_SIZE) {
+    uint32_t frames = frameCount - offset;
+    if (frames > AUDIO_BLOCK_SIZE)
+      frames = AUDIO_BLOCK_SIZE;
+
+    // Render note envelopes and sample voices for the whole block up front
+    for (int j = 0; j < MAX_INSTRUMENTS; j++) {
+      render_envelope(j, frames);
+    }
+    if (Instruments[1].voiceType == VOICE_SAMPLER) {
+      memset(sampler_buffer, 0, sizeof(sampler_buffer));
+      sampler_render(sampler_buffer, frames);
+    }
+    memset(string_buffer, 0, sizeof(string_buffer));
+    waveguide_render(string_buffer, frames);
 
-    // Process all instruments
+    memset(master_buffer, 0, sizeof(master_buffer));
+    memset(master_buffer_right, 0, sizeof(master_buffer_right));
     for (int j = 0; j < MAX_INSTRUMENTS; j++) {
-      callbacks[j](&sample, i, &Instruments[j], &modPhases[j]);
+      FMSynth *fmSynth = &Instruments[j];
+      VoiceBlock block = {0};
+      callbacks[j](fmSynth, &block);
+      if (block.filterMode != filter_modes[j])
+        switch_filter_mode(j, block.filterMode);
+      int unison = fmSynth->unison < unison_limit ? fmSynth->unison
+                                                  : unison_limit;
+
+      // Once a gated-off voice's filter tail has died away it stops
+      // rendering until it is unmuted or retriggered
+      bool stereo = false;
+      bool gated_off = voice_gated_off(j, &block);
+      if (gated_off && dormant[j]) {
+        memset(voice_buffer, 0, frames * sizeof(float));
+      } else {
+        stereo = render_voice(j, &block, unison, voice_buffer,
+                              voice_buffer_right, frames);
+        dormant[j] = gated_off &&
+                     block_is_silent(voice_buffer,
+                                     stereo ? voice_buffer_right : voice_buffer,
+                                     frames);
+        if (dormant[j]) {
+          filter_states[j] = (ResonantFilter){0};
+          filter_states_right[j] = (ResonantFilter){0};
+        }
+      }
+      const float *right = stereo ? voice_buffer_right : voice_buffer;
+      last_outputs[j][0] = voice_buffer[frames - 1];
+      last_outputs[j][1] = right[frames - 1];
+
+      for (uint32_t i = 0; i < frames; i++) {
+        master_buffer[i] += voice_buffer[i];
+        master_buffer_right[i] += right[i];
+        fmSynth->buffer[(offset + i) % BUFFER_SIZE] =
+            0.5f * (voice_buffer[i] + right[i]);
+      }
     }
 
-    // Only reset beat_triggered after processing all instruments for this frame
-    if (beat_triggered) {
-      globalControls.beat_triggered = false;
+    // The instruments become the vocoder carrier, strings stay dry
+    if (vocoder_enabled() && tier < QUALITY_BYPASS) {
+      for (uint32_t i = 0; i < frames; i++) {
+        carrier_buffer[i] = 0.5f * (master_buffer[i] + master_buffer_right[i]);
+      }
+      const float *capture = input ? input + offset : NULL;
+      vocoder_process(capture, carrier_buffer, master_buffer, frames);
+      memcpy(master_buffer_right, master_buffer, frames * sizeof(float));
     }
-    if (sub_beat_triggered) {
-      globalControls.sub_beat_triggered = false;
+
+    // Grains read the dry mix of earlier blocks, never their own output
+    memset(grain_buffer, 0, sizeof(grain_buffer));
+    memset(grain_buffer_right, 0, sizeof(grain_buffer_right));
+    GranularControls grain_controls;
+    granular_controls_from_rope(&grain_controls);
+    granular_render(&grain_controls, grain_buffer, grain_buffer_right, frames);
+
+    for (uint32_t i = 0; i < frames; i++) {
+      float dry_left = master_buffer[i] + string_buffer[i];
+      float dry_right = master_buffer_right[i] + string_buffer[i];
+      carrier_buffer[i] = 0.5f * (dry_left + dry_right);
+
+      master_buffer[i] = (dry_left + grain_buffer[i]) * MASTER_GAIN;
+      master_buffer_right[i] =
+          (dry_right + grain_buffer_right[i]) * MASTER_GAIN;
     }
+    granular_capture(carrier_buffer, frames);
+
+    // The limiter keeps peaks out of the converter's hard clip
+    limiter_process(&master_limiter, master_buffer, master_buffer_right,
+                    frames);
 
-    sample /= MAX_INSTRUMENTS; // Prevent clipping
+    for (uint32_t i = 0; i < frames; i++) {
+      // Write stereo output, the analyser gets the mid signal
+      out[(offset + i) * 2] = master_buffer[i];
+      out[(offset + i) * 2 + 1] = master_buffer_right[i];
+      master_buffer[i] = 0.5f * (master_buffer[i] + master_buffer_right[i]);
+    }
 
-    // Write stereo output
-    out[i * 2] = sample;
-    out[i * 2 + 1] = sample;
+    if (tier < QUALITY_BYPASS)
+      spectrum_tap(master_buffer, frames);
   }
+
+  recorder_write(out, frameCount);
+
+  governor_update(start_time, frameCount, sampleRate);
+  atomic_fetch_add(&audio_epoch, 1);
 }
@@ -0,0 +1,146 @@
+#include "unison.h"
+#include "simd.h"
+
+#define UNISON_GROUPS (UNISON_MAX_VOICES / UNISON_LANES)
+
+// Per-block setup: detune ratios, equal-power pan gains and, the first time
+// through, a random starting phase per voice so the stack doesn't phase-lock
+static int prepare_voices(UnisonState *state, int voices, float frequency,
+                          float detune, float spread) {
+  if (!state->seeded) {
+    uint32_t seed = 0x9E3779B9u;
+    for (int v = 0; v < UNISON_MAX_VOICES; v++) {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      state->phases[v] = (seed >> 8) * (1.0f / 16777216.0f);
+    }
+    state->seeded = true;
+  }
+
+  float norm = 1.0f / sqrtf((float)voices);
+  for (int v = 0; v < UNISON_MAX_VOICES; v++) {
+    if (v >= voices) {
+      // Idle lanes still run but contribute nothing
+      state->increments[v] = 0.0f;
+      state->gains_left[v] = 0.0f;
+      state->gains_right[v] = 0.0f;
+      continue;
+    }
+    float position = voices > 1 ? 2.0f * v / (voices - 1) - 1.0f : 0.0f;
+    float ratio = powf(2.0f, position * detune / 1200.0f);
+    state->increments[v] = frequency * ratio / sampleRate;
+
+    float pan = (position * spread + 1.0f) * 0.25f * PI; // 0 .. PI/2
+    state->gains_left[v] = cosf(pan) * norm;
+    state->gains_right[v] = sinf(pan) * norm;
+  }
+  return (voices + UNISON_LANES - 1) / UNISON_LANES;
+}
+
+#ifdef SIMD_VECTORS
+
+// Waveforms on a vector of phases in [0, 1)
+#define V_SAWTOOTH(p) (2.0f * (p) - 1.0f)
+#define V_SQUARE(p) (1.0f - 2.0f * V_STEP((p) >= V_HALF))
+#define V_TRIANGLE(p) (1.0f - 4.0f * V_ABS((p) - V_HALF))
+// Parabolic sine approximation, no transcendental calls
+#define V_SINE(p) unison_vsine(p)
+
+static inline v4f unison_vsine(v4f p) {
+  v4f x = 1.0f - 2.0f * p; // sin(2*PI*p) == sin(PI*x)
+  v4f y = 4.0f * x * (1.0f - V_ABS(x));
+  return 0.225f * (y * V_ABS(y) - y) + y;
+}
+
+#define DEFINE_UNISON_LOOP(name, SHAPE)                                        \
+  static void name(UnisonState *state, int groups, float volume,              \
+                   const float *env, float *out_left, float *out_right,       \
+                   int frames) {                                              \
+    v4f phases[UNISON_GROUPS], increments[UNISON_GROUPS];                     \
+    v4f gains_left[UNISON_GROUPS], gains_right[UNISON_GROUPS];                \
+    for (int g = 0; g < groups; g++) {                                        \
+      phases[g] = v4f_load(&state->phases[g * 4]);                            \
+      increments[g] = v4f_load(&state->increments[g * 4]);                    \
+      gains_left[g] = v4f_load(&state->gains_left[g * 4]);                    \
+      gains_right[g] = v4f_load(&state->gains_right[g * 4]);                  \
+    }                                                                         \
+    for (int i = 0; i < frames; i++) {                                        \
+      v4f left = {0}, right = {0};                                            \
+      for (int g = 0; g < groups; g++) {                                      \
+        v4f p = phases[g];                                                    \
+        v4f s = SHAPE(p);                                                     \
+        left += s * gains_left[g];                                            \
+        right += s * gains_right[g];                                          \
+        p += increments[g];                                                   \
+        phases[g] = p - V_STEP(p >= V_ONE);                                   \
+      }                                                                       \
+      float gain = volume * (env ? env[i] : 1.0f);                            \
+      out_left[i] = v4f_sum(left) * gain;                                     \
+      out_right[i] = v4f_sum(right) * gain;                                   \
+    }                                                                         \
+    for (int g = 0; g < groups; g++) {                                        \
+      v4f_store(&state->phases[g * 4], phases[g]);                            \
+    }                                                                         \
+  }
+
+#else
+
+// Portable fallback: same maths, one lane at a time
+#define V_SAWTOOTH(p) (2.0f * (p) - 1.0f)
+#define V_SQUARE(p) ((p) < 0.5f ? 1.0f : -1.0f)
+#define V_TRIANGLE(p) (1.0f - 4.0f * fabsf((p) - 0.5f))
+#define V_SINE(p) sinf(2.0f * PI * (p))
+
+#define DEFINE_UNISON_LOOP(name, SHAPE)                                        \
+  static void name(UnisonState *state, int groups, float volume,              \
+                   const float *env, float *out_left, float *out_right,       \
+                   int frames) {                                              \
+    int lanes = groups * UNISON_LANES;                                        \
+    for (int i = 0; i < frames; i++) {                                        \
+      float left = 0.0f, right = 0.0f;                                        \
+      for (int v = 0; v < lanes; v++) {                                       \
+        float p = state->phases[v];                                           \
+        float s = SHAPE(p);                                                   \
+        left += s * state->gains_left[v];                                     \
+        right += s * state->gains_right[v];                                   \
+        p += state->increments[v];                                            \
+        state->phases[v] = p >= 1.0f ? p - 1.0f : p;                          \
+      }                                                                       \
+      float gain = volume * (env ? env[i] : 1.0f);                            \
+      out_left[i] = left * gain;                                              \
+      out_right[i] = right * gain;                                            \
+    }                                                                         \
+  }
+
+#endif
+
+DEFINE_UNISON_LOOP(unison_sine, V_SINE)
+DEFINE_UNISON_LOOP(unison_square, V_SQUARE)
+DEFINE_UNISON_LOOP(unison_triangle, V_TRIANGLE)
+DEFINE_UNISON_LOOP(unison_sawtooth, V_SAWTOOTH)
+
+void unison_render(UnisonState *state, int shape, int voices, float frequency,
+                   float detune, float spread, float volume, const float *env,
+                   float *out_left, float *out_right, int frames) {
+  if (voices < 1)
+    voices = 1;
+  if (voices > UNISON_MAX_VOICES)
+    voices = UNISON_MAX_VOICES;
+
+  int groups = prepare_voices(state, voices, frequency, detune, spread);
+  switch (shape) {
+  case SQUARE:
+    unison_square(state, groups, volume, env, out_left, out_right, frames);
+    break;
+  case TRIANGLE:
+    unison_triangle(state, groups, volume, env, out_left, out_right, frames);
+    break;
+  case SAWTOOTH:
+    unison_sawtooth(state, groups, volume, env, out_left, out_right, frames);
+    break;
+  default:
+    unison_sine(state, groups, volume, env, out_left, out_right, frames);
+    break;
+  }
+}
@@ -0,0 +1,210 @@
+#include "vocoder.h"
+#include "denormal.h"
+#include "sampler.h"
+#include "simd.h"
+#include <stdatomic.h>
+
+// Band-pass bank stored structure-of-arrays so one vector op runs four
+// bands. Each band filters both signals with the same coefficients
+// (b1 = 0, b2 = -b0) in transposed direct form II.
+static float band_b0[VOCODER_BANDS];
+static float band_a1[VOCODER_BANDS];
+static float band_a2[VOCODER_BANDS];
+static float modulator_z1[VOCODER_BANDS];
+static float modulator_z2[VOCODER_BANDS];
+static float carrier_z1[VOCODER_BANDS];
+static float carrier_z2[VOCODER_BANDS];
+static float envelope[VOCODER_BANDS];
+static float attack_coef = 0.0f;
+static float release_coef = 0.0f;
+
+static float modulator_buffer[AUDIO_BLOCK_SIZE];
+static Sample input_file = {0};
+static bool has_input_file = false;
+static double file_position = 0.0;
+static double file_rate = 1.0;
+static bool has_capture = false;
+static atomic_bool enabled = false;
+
+// Called before the audio device starts, like the sampler kit
+bool vocoder_open_input(const char *path) {
+  has_input_file = sample_open(&input_file, path);
+  return has_input_file;
+}
+
+// Log-spaced bands, each one as wide as the gap to its neighbour
+void vocoder_init(bool capture) {
+  has_capture = capture;
+  float ratio =
+      powf(VOCODER_MAX_FREQ / VOCODER_MIN_FREQ, 1.0f / (VOCODER_BANDS - 1));
+  float octaves = log2f(ratio);
+  float q = sqrtf(exp2f(octaves)) / (exp2f(octaves) - 1.0f);
+  for (int b = 0; b < VOCODER_BANDS; b++) {
+    float center = VOCODER_MIN_FREQ * powf(ratio, (float)b);
+    center = fminf(center, sampleRate * 0.45f);
+    float w0 = 2.0f * PI * center / sampleRate;
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    band_b0[b] = alpha / a0;
+    band_a1[b] = -2.0f * cosf(w0) / a0;
+    band_a2[b] = (1.0f - alpha) / a0;
+    modulator_z1[b] = modulator_z2[b] = 0.0f;
+    carrier_z1[b] = carrier_z2[b] = 0.0f;
+    envelope[b] = 0.0f;
+  }
+  attack_coef = 1.0f - expf(-1.0f / (VOCODER_ATTACK * sampleRate));
+  release_coef = 1.0f - expf(-1.0f / (VOCODER_RELEASE * sampleRate));
+
+  file_position = 0.0;
+  if (has_input_file)
+    file_rate = input_file.sample_rate / sampleRate;
+}
+
+void vocoder_set_enabled(bool value) { atomic_store(&enabled, value); }
+
+bool vocoder_enabled() { return atomic_load(&enabled); }
+
+// The file wins when both exist, so a run can be reproduced exactly
+int vocoder_source() {
+  if (has_input_file)
+    return VOCODER_SOURCE_FILE;
+  if (has_capture)
+    return VOCODER_SOURCE_DEVICE;
+  return VOCODER_SOURCE_NONE;
+}
+
+const char *vocoder_source_name() {
+  switch (vocoder_source()) {
+  case VOCODER_SOURCE_FILE:
+    return "file";
+  case VOCODER_SOURCE_DEVICE:
+    return "mic";
+  default:
+    return "no input";
+  }
+}
+
+// Loop the input file, resampled to the device rate
+static void read_input_file(float *out, int frames) {
+  uint32_t last = input_file.frame_count - 1;
+  for (int i = 0; i < frames; i++) {
+    uint32_t index = (uint32_t)file_position;
+    float frac = (float)(file_position - index);
+    uint32_t next = index < last ? index + 1 : 0;
+    float a = sample_read_frame(&input_file, index);
+    float b = sample_read_frame(&input_file, next);
+    out[i] = a + (b - a) * frac;
+
+    file_position += file_rate;
+    if (file_position >= last)
+      file_position -= last;
+  }
+}
+
+#ifdef SIMD_VECTORS
+
+// Bands outer, samples inner: one group's state stays in registers for the
+// whole block and its output is folded into out lane by lane
+static void process_bands(const float *modulator, const float *carrier,
+                          float *out, int frames) {
+  v4f attack = {attack_coef, attack_coef, attack_coef, attack_coef};
+  v4f release = {release_coef, release_coef, release_coef, release_coef};
+  for (int b = 0; b < VOCODER_BANDS; b += 4) {
+    v4f b0 = v4f_load(&band_b0[b]);
+    v4f a1 = v4f_load(&band_a1[b]);
+    v4f a2 = v4f_load(&band_a2[b]);
+    v4f mz1 = v4f_load(&modulator_z1[b]);
+    v4f mz2 = v4f_load(&modulator_z2[b]);
+    v4f cz1 = v4f_load(&carrier_z1[b]);
+    v4f cz2 = v4f_load(&carrier_z2[b]);
+    v4f env = v4f_load(&envelope[b]);
+
+    for (int i = 0; i < frames; i++) {
+      v4f m = b0 * modulator[i];
+      v4f my = m + mz1;
+      mz1 = mz2 - a1 * my;
+      mz2 = -m - a2 * my;
+
+      v4f c = b0 * carrier[i];
+      v4f cy = c + cz1;
+      cz1 = cz2 - a1 * cy;
+      cz2 = -c - a2 * cy;
+
+      v4f level = V_ABS(my);
+      v4f rising = V_STEP(level > env);
+      env += (release + (attack - release) * rising) * (level - env);
+
+      out[i] += v4f_sum(cy * env);
+    }
+
+    v4f_store(&modulator_z1[b], mz1);
+    v4f_store(&modulator_z2[b], mz2);
+    v4f_store(&carrier_z1[b], cz1);
+    v4f_store(&carrier_z2[b], cz2);
+    v4f_store(&envelope[b], env);
+  }
+}
+
+#else
+
+static void process_bands(const float *modulator, const float *carrier,
+                          float *out, int frames) {
+  for (int b = 0; b < VOCODER_BANDS; b++) {
+    for (int i = 0; i < frames; i++) {
+      float m = band_b0[b] * modulator[i];
+      float my = m + modulator_z1[b];
+      modulator_z1[b] = modulator_z2[b] - band_a1[b] * my;
+      modulator_z2[b] = -m - band_a2[b] * my;
+
+      float c = band_b0[b] * carrier[i];
+      float cy = c + carrier_z1[b];
+      carrier_z1[b] = carrier_z2[b] - band_a1[b] * cy;
+      carrier_z2[b] = -c - band_a2[b] * cy;
+
+      float level = fabsf(my);
+      float coef = level > envelope[b] ? attack_coef : release_coef;
+      envelope[b] += coef * (level - envelope[b]);
+
+      out[i] += cy * envelope[b];
+    }
+  }
+}
+
+#endif
+
+// Shape the carrier with the spectral envelope of the input. input is the
+// capture buffer for this block, or NULL to read the input file.
+void vocoder_process(const float *input, const float *carrier, float *out,
+                     int frames) {
+  const float *modulator = input;
+  if (has_input_file) {
+    read_input_file(modulator_buffer, frames);
+    modulator = modulator_buffer;
+  } else if (!modulator) {
+    memset(modulator_buffer, 0, frames * sizeof(float));
+    modulator = modulator_buffer;
+  }
+
+  memset(out, 0, frames * sizeof(float));
+  process_bands(modulator, carrier, out, frames);
+  for (int i = 0; i < frames; i++) {
+    out[i] *= VOCODER_GAIN;
+  }
+
+  // Silent input lets the band states decay towards subnormals
+  for (int b = 0; b < VOCODER_BANDS; b++) {
+    modulator_z1[b] = flush_denormal(modulator_z1[b]);
+    modulator_z2[b] = flush_denormal(modulator_z2[b]);
+    carrier_z1[b] = flush_denormal(carrier_z1[b]);
+    carrier_z2[b] = flush_denormal(carrier_z2[b]);
+    envelope[b] = flush_denormal(envelope[b]);
+  }
+}
+
+// Only call once the audio device is stopped
+void vocoder_shutdown() {
+  atomic_store(&enabled, false);
+  if (has_input_file)
+    sample_close(&input_file);
+  has_input_file = false;
+}
@@ -0,0 +1,152 @@
+#include "waveguide.h"
+#include "denormal.h"
+#include <stdatomic.h>
+
+#define WAVEGUIDE_MASK (WAVEGUIDE_RING_SIZE - 1)
+#define WAVEGUIDE_SILENCE 1e-4f
+
+static WaveguideString strings[WAVEGUIDE_MAX_STRINGS] = {0};
+static int string_limit = WAVEGUIDE_MAX_STRINGS;
+static uint32_t pluck_count = 0;
+static uint32_t noise_state = 0x2545F491u;
+static atomic_int active_strings = 0; // Published for the render thread
+
+// SPSC queue: the render thread plucks, the audio thread drains
+static PluckEvent events[WAVEGUIDE_EVENTS];
+static atomic_uint event_write = 0;
+static atomic_uint event_read = 0;
+
+static float noise() {
+  noise_state ^= noise_state << 13;
+  noise_state ^= noise_state >> 17;
+  noise_state ^= noise_state << 5;
+  return (noise_state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+void waveguide_pluck(float frequency, float velocity, float tension) {
+  unsigned write = atomic_load_explicit(&event_write, memory_order_relaxed);
+  unsigned read = atomic_load_explicit(&event_read, memory_order_acquire);
+  if (write - read >= WAVEGUIDE_EVENTS)
+    return; // Queue full, drop the pluck
+
+  events[write & (WAVEGUIDE_EVENTS - 1)] = (PluckEvent){
+      .frequency = frequency,
+      .velocity = fminf(fmaxf(velocity, 0.0f), 1.0f),
+      .tension = fminf(fmaxf(tension, 0.0f), 1.0f),
+  };
+  atomic_store_explicit(&event_write, write + 1, memory_order_release);
+}
+
+void waveguide_set_string_limit(int limit) {
+  if (limit < 1)
+    limit = 1;
+  if (limit > WAVEGUIDE_MAX_STRINGS)
+    limit = WAVEGUIDE_MAX_STRINGS;
+  // Strings past the new limit are cut rather than left to ring out
+  for (int i = limit; i < string_limit; i++) {
+    strings[i].active = false;
+  }
+  string_limit = limit;
+}
+
+// Free string if there is one, otherwise the oldest pluck
+static WaveguideString *allocate_string() {
+  WaveguideString *oldest = &strings[0];
+  for (int i = 0; i < string_limit; i++) {
+    if (!strings[i].active)
+      return &strings[i];
+    if (strings[i].age < oldest->age)
+      oldest = &strings[i];
+  }
+  return oldest;
+}
+
+static void start_string(const PluckEvent *event) {
+  WaveguideString *string = allocate_string();
+  float frequency = fmaxf(event->frequency, WAVEGUIDE_MIN_FREQ);
+  frequency = fminf(frequency, sampleRate * 0.25f);
+
+  // Slack strings are dull, taut ones bright
+  string->damping = lerp1D(0.6f, 0.05f, event->tension);
+  string->damping_state = 0.0f;
+
+  // Loop length in samples minus the damping filter's delay at DC, split
+  // into an integer delay and an allpass fraction kept within [0.5, 1.5)
+  float period = sampleRate / frequency;
+  float length = period - string->damping / (1.0f - string->damping);
+  float whole = floorf(length - 0.5f);
+  float fraction = length - whole;
+  string->delay = (uint32_t)whole;
+  if (string->delay >= WAVEGUIDE_RING_SIZE)
+    string->delay = WAVEGUIDE_RING_SIZE - 1;
+  string->allpass_coef = (1.0f - fraction) / (1.0f + fraction);
+  string->allpass_x1 = 0.0f;
+  string->allpass_y1 = 0.0f;
+  string->loss = powf(0.001f, 1.0f / (frequency * WAVEGUIDE_DECAY));
+
+  // Excite with a noise burst one period long, smoothed like the damping
+  // filter so the attack matches the string's brightness
+  float smooth = 0.0f;
+  for (uint32_t i = 0; i < string->delay; i++) {
+    float excitation = noise();
+    smooth = excitation + string->damping * (smooth - excitation);
+    string->ring[(string->write + i) & WAVEGUIDE_MASK] =
+        smooth * event->velocity;
+  }
+  string->write += string->delay;
+  string->age = ++pluck_count;
+  string->active = true;
+}
+
+static void render_string(WaveguideString *string, float *out, int frames) {
+  float *ring = string->ring;
+  uint32_t write = string->write;
+  uint32_t delay = string->delay;
+  float coef = string->allpass_coef;
+  float x1 = string->allpass_x1;
+  float y1 = string->allpass_y1;
+  float damping = string->damping;
+  float state = string->damping_state;
+  float loss = string->loss;
+  float peak = 0.0f;
+
+  for (int i = 0; i < frames; i++) {
+    float sample = ring[(write - delay) & WAVEGUIDE_MASK];
+    state = sample + damping * (state - sample);
+    float tuned = coef * state + x1 - coef * y1;
+    x1 = state;
+    y1 = tuned;
+    ring[write & WAVEGUIDE_MASK] = tuned * loss;
+    write++;
+
+    out[i] += sample * WAVEGUIDE_GAIN;
+    peak = fmaxf(peak, fabsf(sample));
+  }
+
+  string->write = write;
+  string->allpass_x1 = flush_denormal(x1);
+  string->allpass_y1 = flush_denormal(y1);
+  string->damping_state = flush_denormal(state);
+  if (peak < WAVEGUIDE_SILENCE)
+    string->active = false;
+}
+
+void waveguide_render(float *out, int frames) {
+  unsigned read = atomic_load_explicit(&event_read, memory_order_relaxed);
+  unsigned write = atomic_load_explicit(&event_write, memory_order_acquire);
+  for (; read != write; read++) {
+    start_string(&events[read & (WAVEGUIDE_EVENTS - 1)]);
+  }
+  atomic_store_explicit(&event_read, read, memory_order_release);
+
+  int active = 0;
+  for (int i = 0; i < string_limit; i++) {
+    if (strings[i].active) {
+      render_string(&strings[i], out, frames);
+      active += strings[i].active;
+    }
+  }
+  atomic_store_explicit(&active_strings, active, memory_order_relaxed);
+}
+
+int waveguide_active_strings() { return atomic_load(&active_strings); }
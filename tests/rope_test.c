@@ -0,0 +1,63 @@
+#include "rope.h"
+#include <stdio.h>
+
+// Headless rope checks: the pointer is fed in directly, so no window is
+// opened. Exits non-zero on the first failure.
+
+#define SETTLE_STEPS 600 // Ten seconds of physics
+#define REST_TIMEOUT 1200
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok)
+    failures++;
+}
+
+static void settle(Rope *rope) {
+  init_rope(rope, (vec2){400, 400}, (vec2){400, 600}, GRAY);
+  for (int s = 0; s < SETTLE_STEPS; s++)
+    update_rope(rope, Vector2Zero(), false);
+}
+
+// A settled rope only has one step of gravity to undo
+static void test_settled_rope_single_pass() {
+  Rope rope;
+  settle(&rope);
+  check(rope_is_at_rest(&rope), "settled rope is at rest");
+  check(rope.iterations == 1, "settled rope solves in one pass");
+}
+
+// Grab the end, pull it sideways over a sixth of a second, let go and wait
+// for the swing to die down
+static void test_drag_release_rests(float offset) {
+  Rope rope;
+  settle(&rope);
+  vec2 grab = rope.end;
+  for (int s = 1; s <= 10; s++) {
+    vec2 pointer = {grab.x + offset * s / 10.0f, grab.y};
+    update_rope(&rope, pointer, true);
+  }
+  check(!rope_is_at_rest(&rope), "dragged rope is awake");
+
+  vec2 release = {grab.x + offset, grab.y};
+  int steps = 0;
+  do {
+    update_rope(&rope, release, false);
+    steps++;
+  } while (!rope_is_at_rest(&rope) && steps < REST_TIMEOUT);
+
+  char what[64];
+  snprintf(what, sizeof(what), "rests after a %.0f px drag (%d steps)", offset,
+           steps);
+  check(rope_is_at_rest(&rope), what);
+}
+
+int main() {
+  test_settled_rope_single_pass();
+  test_drag_release_rests(10.0f);
+  test_drag_release_rests(40.0f);
+  test_drag_release_rests(150.0f);
+  return failures > 0;
+}